@@ -0,0 +1,121 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// Decoder throughput for DXT1/3/5, on synthetic textures or DDS files given on the command line.
+// Built with -DNWN_BUILD_BENCHMARKS=ON.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+#include "stb_dds.hpp"
+
+namespace
+{
+    void put32(std::vector<unsigned char>& file, uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            file.push_back(static_cast<unsigned char>(value >> (i * 8)));
+        }
+    }
+
+    // Standard DDS header followed by random blocks, a single level
+    std::vector<unsigned char> makeTexture(int fourcc, int width, int height)
+    {
+        std::vector<unsigned char> file;
+        put32(file, 0x20534444); // Magic
+        put32(file, 124); // Header size
+        put32(file, 0); // Flags
+        put32(file, height);
+        put32(file, width);
+        for (int i = 0; i < 3 + 11; ++i) // Pitch, depth, mip count, reserved
+            put32(file, 0);
+        put32(file, 32); // Pixel format size
+        put32(file, 4); // DDPF_FOURCC
+        put32(file, fourcc == 1 ? 0x31545844 : fourcc == 3 ? 0x33545844 : 0x35545844);
+        for (int i = 0; i < 5 + 5; ++i) // Bit masks, caps, reserved
+            put32(file, 0);
+
+        std::mt19937 rng(fourcc);
+        size_t size = static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * (fourcc == 1 ? 8 : 16);
+        for (size_t i = 0; i < size; ++i)
+            file.push_back(static_cast<unsigned char>(rng()));
+        return file;
+    }
+
+    void measure(const char* label, const std::vector<unsigned char>& file)
+    {
+        stbi_dds_compressed dds;
+        if (!stbi_dds_parse_memory(file.data(), static_cast<int>(file.size()), &dds))
+        {
+            std::printf("%-24s not a DXT1/3/5 DDS file\n", label);
+            return;
+        }
+
+        // Repeat until at least half a second has been measured
+        using Clock = std::chrono::steady_clock;
+        int iterations = 0;
+        double seconds = 0.0;
+        while (seconds < 0.5)
+        {
+            auto start = Clock::now();
+            int width, height;
+            unsigned char* pixels = stbi_dds_decode_level(&dds, 0, &width, &height, 4);
+            seconds += std::chrono::duration<double>(Clock::now() - start).count();
+            std::free(pixels);
+            ++iterations;
+        }
+
+        double decodedMB = static_cast<double>(dds.width) * dds.height * 4 / (1024.0 * 1024.0);
+        std::printf("%-24s DXT%d %5dx%-5d %8.3f ms %9.1f MB/s\n", label, dds.fourcc, dds.width, dds.height,
+                    seconds * 1000.0 / iterations, decodedMB * iterations / seconds);
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc > 1)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::ifstream in(argv[i], std::ios::binary);
+            std::vector<unsigned char> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            measure(argv[i], file);
+        }
+        return 0;
+    }
+
+    const int formats[] = {1, 3, 5};
+    const int sizes[] = {128, 512, 2048};
+    for (int fourcc : formats)
+    {
+        for (int size : sizes)
+        {
+            std::string label = "synthetic " + std::to_string(size);
+            measure(label.c_str(), makeTexture(fourcc, size, size));
+        }
+    }
+    return 0;
+}
@@ -23,8 +23,17 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtx/quaternion.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
+#include "model_node.hpp"
+
+class MappedFile;
 
 struct AnimationKeyframe
 {
@@ -36,32 +45,173 @@ struct AnimationKeyframe
     AnimationKeyframe(float t, const glm::vec3& v) : time(t), value(v) {}
 };
 
+// Remembers the last evaluated key segment so playback with increasing time steps forward instead of searching
+struct AnimationCursor
+{
+    size_t segment = 0;
+};
+
+// Index of the key that starts the segment containing time, which must lie strictly inside the keys' range.
+// Steps forward from hint when time has advanced, otherwise binary searches.
+template <typename Key>
+size_t findKeySegment(const std::vector<Key>& keys, float time, size_t hint)
+{
+    if (hint + 1 >= keys.size() || time < keys[hint].time)
+    {
+        auto next = std::upper_bound(keys.begin(), keys.end(), time,
+                                     [](float t, const Key& key) { return t < key.time; });
+        hint = static_cast<size_t>(next - keys.begin()) - 1;
+    }
+    while (time > keys[hint + 1].time)
+    {
+        ++hint;
+    }
+    return hint;
+}
+
 struct AnimationTrack
 {
     std::vector<AnimationKeyframe> keyframes;
 
     glm::vec3 getValueAtTime(float time) const
     {
+        AnimationCursor cursor{keyframes.size()};
+        return getValueAtTime(time, cursor);
+    }
+
+    glm::vec3 getValueAtTime(float time, AnimationCursor& cursor) const
+    {
+        if (!baked.empty())
+            return sampleBaked(time);
         if (keyframes.empty())
             return glm::vec3(0.0f);
-        if (keyframes.size() == 1)
-            return keyframes[0].value;
+        if (time <= keyframes.front().time)
+            return keyframes.front().value;
+        if (time >= keyframes.back().time)
+            return keyframes.back().value;
+
+        cursor.segment = findKeySegment(keyframes, time, cursor.segment);
+        return interpolate(cursor.segment, time);
+    }
+
+    // Resample into a uniform table for constant-time lookup; keys denser than the interval are smoothed out
+    void bake(float sampleInterval);
+    bool isBaked() const { return !baked.empty(); }
+    void unbake() { baked.clear(); }
 
-        // Find the two keyframes to interpolate between
-        for (size_t i = 0; i < keyframes.size() - 1; ++i)
+    void clear()
+    {
+        keyframes.clear();
+        baked.clear();
+    }
+
+private:
+    glm::vec3 interpolate(size_t segment, float time) const
+    {
+        const AnimationKeyframe& a = keyframes[segment];
+        const AnimationKeyframe& b = keyframes[segment + 1];
+        float span = b.time - a.time;
+        if (span <= 0.0f)
+            return b.value;
+        return glm::mix(a.value, b.value, (time - a.time) / span);
+    }
+
+    glm::vec3 sampleBaked(float time) const
+    {
+        float position = glm::clamp((time - bakedStart) / bakedInterval, 0.0f, static_cast<float>(baked.size() - 1));
+        size_t index = std::min(static_cast<size_t>(position), baked.size() - 2);
+        return glm::mix(baked[index], baked[index + 1], position - static_cast<float>(index));
+    }
+
+    std::vector<glm::vec3> baked;
+    float bakedStart = 0.0f;
+    float bakedInterval = 1.0f;
+};
+
+struct QuaternionKeyframe
+{
+    float time;
+    glm::quat value;
+
+    QuaternionKeyframe(float t, const glm::quat& q) : time(t), value(q) {}
+};
+
+// Orientation keys as unit quaternions, interpolated with nlerp along the shorter arc
+struct QuaternionTrack
+{
+    std::vector<QuaternionKeyframe> keyframes;
+
+    // Orientations around time and the blend weight between them, from the baked table if there is one
+    void findBlend(float time, size_t& hint, glm::quat& from, glm::quat& to, float& weight) const
+    {
+        if (!baked.empty())
+        {
+            float position =
+                glm::clamp((time - bakedStart) / bakedInterval, 0.0f, static_cast<float>(baked.size() - 1));
+            size_t index = std::min(static_cast<size_t>(position), baked.size() - 2);
+            from = baked[index];
+            to = baked[index + 1];
+            weight = position - static_cast<float>(index);
+            return;
+        }
+
+        weight = 0.0f;
+        if (time <= keyframes.front().time)
+        {
+            from = to = keyframes.front().value;
+            return;
+        }
+        if (time >= keyframes.back().time)
         {
-            if (time >= keyframes[i].time && time <= keyframes[i + 1].time)
-            {
-                float t = (time - keyframes[i].time) / (keyframes[i + 1].time - keyframes[i].time);
-                return glm::mix(keyframes[i].value, keyframes[i + 1].value, t);
-            }
+            from = to = keyframes.back().value;
+            return;
         }
 
-        // If time is outside range, return closest value
-        if (time < keyframes[0].time)
-            return keyframes[0].value;
-        return keyframes.back().value;
+        hint = findKeySegment(keyframes, time, hint);
+        from = keyframes[hint].value;
+        to = keyframes[hint + 1].value;
+        float span = keyframes[hint + 1].time - keyframes[hint].time;
+        weight = span > 0.0f ? (time - keyframes[hint].time) / span : 1.0f;
+    }
+
+    glm::quat getValueAtTime(float time, AnimationCursor& cursor) const
+    {
+        if (keyframes.empty())
+            return glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        glm::quat from, to;
+        float weight;
+        findBlend(time, cursor.segment, from, to, weight);
+        return nlerp(from, to, weight);
+    }
+
+    glm::quat getValueAtTime(float time) const
+    {
+        AnimationCursor cursor{keyframes.size()};
+        return getValueAtTime(time, cursor);
+    }
+
+    static glm::quat nlerp(const glm::quat& from, glm::quat to, float weight)
+    {
+        if (glm::dot(from, to) < 0.0f)
+            to = -to;
+        return glm::normalize(from + (to - from) * weight);
+    }
+
+    // Same as AnimationTrack::bake
+    void bake(float sampleInterval);
+    bool isBaked() const { return !baked.empty(); }
+    void unbake() { baked.clear(); }
+
+    void clear()
+    {
+        keyframes.clear();
+        baked.clear();
     }
+
+private:
+    std::vector<glm::quat> baked;
+    float bakedStart = 0.0f;
+    float bakedInterval = 1.0f;
 };
 
 enum class UpdateType
@@ -152,18 +302,27 @@ struct EmitterNode
     float mass = 1.0f;
     float particleRot = 0.0f;
 
-    // Color and opacity
+    // Color and opacity, mid keys are unused while negative
     glm::vec3 colorStart = {1.0f, 1.0f, 1.0f};
+    glm::vec3 colorMid = {-1.0f, -1.0f, -1.0f};
     glm::vec3 colorEnd = {1.0f, 1.0f, 1.0f};
     float alphaStart = 1.0f;
+    float alphaMid = -1.0f;
     float alphaEnd = 1.0f;
 
     // Size
     float sizeStart = 1.0f;
+    float sizeMid = -1.0f;
     float sizeEnd = 1.0f;
     float sizeStart_y = 0.0f;
+    float sizeMid_y = -1.0f;
     float sizeEnd_y = 0.0f;
 
+    // Fractions of particle life at which the start, mid and end keys apply
+    float percentStart = 0.0f;
+    float percentMid = 0.5f;
+    float percentEnd = 1.0f;
+
     // Advanced properties
     float grav = 0.0f;
     float drag = 0.0f;
@@ -187,7 +346,7 @@ struct EmitterNode
 
     // Animation tracks
     AnimationTrack positionKeys;
-    AnimationTrack orientationKeys;
+    QuaternionTrack orientationKeys;
 
     // Get animated values at specific time
     glm::vec3 getAnimatedPosition(float time) const
@@ -197,10 +356,17 @@ struct EmitterNode
         return positionKeys.getValueAtTime(time);
     }
 
-    glm::vec3 getAnimatedOrientation(float time) const
+    glm::vec3 getAnimatedPosition(float time, AnimationCursor& cursor) const
+    {
+        if (positionKeys.keyframes.empty())
+            return position;
+        return positionKeys.getValueAtTime(time, cursor);
+    }
+
+    glm::quat getAnimatedOrientation(float time) const
     {
         if (orientationKeys.keyframes.empty())
-            return glm::vec3(0.0f);
+            return getOrientation();
         return orientationKeys.getValueAtTime(time);
     }
 
@@ -234,37 +400,158 @@ struct EmitterNode
     }
 };
 
+enum class MDLFormat
+{
+    Ascii,
+    Binary // Compiled model
+};
+
+// Optional hooks for loading on a worker thread
+struct MDLLoadObserver
+{
+    std::function<void(uint64_t bytesRead)> progress; // Called periodically with the bytes consumed so far
+    std::function<void(const std::string& texture)> textureFound; // Called for each texture name as it is parsed
+    const std::atomic<bool>* cancel = nullptr; // Loading stops and returns false once this is set
+};
+
 class EmitterEditor
 {
 public:
     EmitterEditor();
     ~EmitterEditor();
 
+    EmitterEditor(const EmitterEditor&) = default;
+    EmitterEditor& operator=(const EmitterEditor&) = default;
+    EmitterEditor(EmitterEditor&&) = default;
+    EmitterEditor& operator=(EmitterEditor&&) = default;
+
     void addEmitter(const std::string& name = "emitter");
     void removeEmitter(int index);
     void duplicateEmitter(int index);
+    void renameEmitter(int index, const std::string& name);
     void resetToNew();
 
+    // Index of the first emitter with the given name, or -1
+    int findEmitter(const std::string& name) const;
+
+    // Must be called after modifying an emitter through getEmitters() so its MDL text is regenerated
+    void touchEmitter(int index);
+
+    // Bumped on every change to the document, unique across editor instances
+    uint64_t getRevision() const { return revision; }
+
 private:
     EmitterNode createDefaultEmitter();
+    void rebuildNameIndex();
+    bool loadFromBinaryMDL(const std::string& filename, const unsigned char* data, size_t size,
+                           const MDLLoadObserver* observer);
+    uint64_t bumpRevision();
+    void resetGenerations();
+    const std::string& getEmitterText(size_t index) const;
+    const std::string& getAnimationBody(size_t index) const;
+    bool readAnimationBody(size_t index) const;
+    bool readAnimationBodies() const; // False if any could not be read
+    void detachFromSource();
+    std::string resolveParent(const std::string& parent) const;
+    std::string exportNodeName(const std::string& name) const;
+    void parseAnimationBody(size_t index);
+    void clearModelData();
+    void bakeTracks(EmitterNode& emitter) const;
+    bool loadFromMemory(const std::string& filename, const unsigned char* data, size_t size,
+                        const MDLLoadObserver* observer);
 
 public:
-    void loadFromMDL(const std::string& filename);
-    void saveToMDL(const std::string& filename);
+    // Returns false if the file could not be opened or loading was cancelled
+    bool loadFromMDL(const std::string& filename, const MDLLoadObserver* observer = nullptr);
+
+    // Load a model from memory that stays mapped, such as a resource inside a mounted archive.
+    // name stands in for the file name, archive keeps data alive for animations that are read later.
+    bool loadFromMDL(const std::string& name, std::shared_ptr<const MappedFile> archive, const unsigned char* data,
+                     size_t size, const MDLLoadObserver* observer = nullptr);
+    // Returns false if the file could not be written, if the animations still to be read from the source could
+    // not be, or if it is the compiled model this one was loaded from and writing it would drop the meshes and
+    // animations that were not loaded
+    bool saveToMDL(const std::string& filename);
     void setModelName(const std::string& name);
 
+    // Resample animation tracks of at least bakeKeyThreshold keys into uniform tables at twice their average key
+    // rate. Off by default: lookups become constant time, but detail between unevenly spaced keys is smoothed out.
+    void setBakeLongTracks(bool bake);
+    bool getBakeLongTracks() const { return bakeLongTracks; }
+    static constexpr size_t bakeKeyThreshold = 1024;
+
+    // Format used by saveToMDL, follows the format of the last loaded file
+    MDLFormat getSaveFormat() const { return saveFormat; }
+
+    void setSaveFormat(MDLFormat format) { saveFormat = format; }
+
+    // Binary output holds dummies and emitters only, models with other nodes or animations must be saved as ASCII
+    bool canSaveBinary() const;
+
+    // For edits other than the name, follow them with touchEmitter(). Renames go through renameEmitter(), which
+    // keeps findEmitter() and the animations current; touchEmitter() completes a name changed here the same way.
     std::vector<EmitterNode>& getEmitters() { return emitters; }
 
     const std::vector<EmitterNode>& getEmitters() const { return emitters; }
 
-    std::string generateMDLText() const;
+    // Regenerates only emitters touched since the last call
+    const std::string& generateMDLText() const;
 
     std::string getTextureDirectory() const { return textureDirectory; }
 
+    // Non-emitter nodes of a loaded model, in file order
+    const std::vector<ModelNode>& getModelNodes() const { return nodes; }
+
+    // Bumped when the model nodes are replaced or a renamed emitter changes their parents
+    uint64_t getModelNodesRevision() const { return modelNodesRevision; }
+
+    const std::vector<ModelAnimation>& getAnimations() const { return animations; }
+
+    int getSelectedAnimation() const { return selectedAnimation; }
+
+    // Parses the animation on first use and loads its emitter keys, -1 clears all keys
+    void selectAnimation(int index);
+
 private:
     std::vector<EmitterNode> emitters;
+    std::unordered_map<std::string, size_t> nameIndex; // Name -> position, kept current by renameEmitter
+
+    // MDL text cache: a block is current while its generation matches the emitter's
+    struct TextBlock
+    {
+        uint64_t generation = 0;
+        std::string text;
+    };
+
+    uint64_t revision = 0;
+    std::vector<uint64_t> emitterGenerations; // Parallel to emitters
+    mutable std::vector<TextBlock> textBlocks;
+    mutable std::string mdlText;
+    mutable uint64_t mdlTextRevision = UINT64_MAX;
     std::string modelName = "emitter_model";
     std::string textureDirectory;
+
+    // Full model data, empty for models created in the editor
+    std::vector<ModelNode> nodes;
+    uint64_t modelNodesRevision = 0;
+    std::vector<ModelAnimation> animations;
+    mutable std::vector<std::string> animationBodies; // Raw text, read from the source when first needed or edited
+    mutable std::vector<bool> animationBodyLoaded;
+    std::string sourceFile;
+    uint64_t sourceSize = 0; // Size and write time of sourceFile when it was parsed
+    int64_t sourceTime = 0;
+    mutable bool sourceChanged = false; // sourceFile no longer matches, unread animations are lost
+    bool detached = false; // detachFromSource() already ran for this model
+    bool incompleteSource = false; // Compiled model with parts that were not read
+    std::shared_ptr<const MappedFile> sourceArchive; // Source of models loaded from an archive instead of a file
+    const unsigned char* sourceData = nullptr;
+    std::string rootNodeName; // Root dummy in the file, written under the current model name
+    std::string supermodel = "NULL";
+    std::string classification = "effect";
+    int selectedAnimation = -1;
+    bool bakeLongTracks = false;
+
+    MDLFormat saveFormat = MDLFormat::Ascii;
 };
 
 #endif // EMITTER_HPP
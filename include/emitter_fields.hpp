@@ -0,0 +1,170 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef EMITTER_FIELDS_HPP
+#define EMITTER_FIELDS_HPP
+
+#include <array>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+#include "emitter.hpp"
+
+// How a field is represented in MDL text
+enum class FieldType
+{
+    Bool, // 0 or 1
+    Int,
+    Float,
+    Color, // r g b
+    Vec3, // x y z
+    String,
+    EnumName, // written by name (update, render, blend)
+    EnumIndex, // written as integer (spawntype)
+    AxisAngle // Euler degrees in the editor, axis-angle radians in the MDL
+};
+
+// When a field is left out of the generated MDL text
+enum class OmitRule
+{
+    Never,
+    IfZero,
+    IfEmpty,
+    IfNoGeometry, // xsize/ysize are only written when the emitter has an area
+    IfDefault // Optional keys, left out while they hold their default value
+};
+
+using EmitterMember =
+    std::variant<bool EmitterNode::*, int EmitterNode::*, float EmitterNode::*, glm::vec3 EmitterNode::*,
+                 std::string EmitterNode::*, UpdateType EmitterNode::*, RenderType EmitterNode::*,
+                 BlendType EmitterNode::*, SpawnType EmitterNode::*>;
+
+struct EmitterField
+{
+    const char* name; // MDL keyword
+    FieldType type;
+    EmitterMember member;
+    float scale = 1.0f; // MDL value = editor value * scale
+    std::array<float, 3> defaultValue = {0.0f, 0.0f, 0.0f}; // Value for newly created emitters
+    OmitRule omit = OmitRule::Never;
+};
+
+inline constexpr std::array<std::string_view, 4> updateTypeNames = {"Fountain", "Single", "Explosion", "Lightning"};
+inline constexpr std::array<std::string_view, 7> renderTypeNames = {"Normal",
+                                                                    "Linked",
+                                                                    "Billboard_to_Local_Z",
+                                                                    "Billboard_to_World_Z",
+                                                                    "Aligned_to_World_Z",
+                                                                    "Aligned_to_Particle_Direction",
+                                                                    "Motion_Blur"};
+inline constexpr std::array<std::string_view, 3> blendTypeNames = {"Normal", "Punch-Through", "Lighten"};
+
+// Every serialized EmitterNode property, in the order it is written to MDL text.
+// name and parent are part of the node header and handled by the parser/writer directly.
+inline constexpr auto emitterFields = std::to_array<EmitterField>({
+    {"p2p", FieldType::Bool, &EmitterNode::p2p},
+    {"p2p_sel", FieldType::Int, &EmitterNode::p2p_sel, 1.0f, {1.0f}},
+    {"affectedByWind", FieldType::Bool, &EmitterNode::affectedByWind},
+    {"m_isTinted", FieldType::Bool, &EmitterNode::m_isTinted},
+    {"bounce", FieldType::Bool, &EmitterNode::bounce},
+    {"random", FieldType::Bool, &EmitterNode::random},
+    {"inherit", FieldType::Bool, &EmitterNode::inherit, 1.0f, {1.0f}},
+    {"inheritvel", FieldType::Bool, &EmitterNode::inheritvel},
+    {"inherit_local", FieldType::Bool, &EmitterNode::inherit_local},
+    {"splat", FieldType::Bool, &EmitterNode::splat},
+    {"inherit_part", FieldType::Bool, &EmitterNode::inherit_part},
+    {"renderorder", FieldType::Int, &EmitterNode::renderorder},
+    {"spawntype", FieldType::EnumIndex, &EmitterNode::spawntype},
+    {"update", FieldType::EnumName, &EmitterNode::update},
+    {"render", FieldType::EnumName, &EmitterNode::render},
+    {"blend", FieldType::EnumName, &EmitterNode::blend, 1.0f, {static_cast<float>(BlendType::Lighten)}},
+    {"texture", FieldType::String, &EmitterNode::texture, 1.0f, {}, OmitRule::IfEmpty},
+    {"xgrid", FieldType::Int, &EmitterNode::xgrid, 1.0f, {1.0f}},
+    {"ygrid", FieldType::Int, &EmitterNode::ygrid, 1.0f, {1.0f}},
+    {"loop", FieldType::Bool, &EmitterNode::loop},
+    {"deadspace", FieldType::Float, &EmitterNode::deadspace},
+    {"twosidedtex", FieldType::Bool, &EmitterNode::twosidedtex},
+    {"blastRadius", FieldType::Float, &EmitterNode::blastRadius},
+    {"blastLength", FieldType::Float, &EmitterNode::blastLength},
+    {"position", FieldType::Vec3, &EmitterNode::position},
+    {"orientation", FieldType::AxisAngle, &EmitterNode::rotationAngles},
+    {"xsize", FieldType::Float, &EmitterNode::xsize, 100.0f, {0.1f}, OmitRule::IfNoGeometry},
+    {"ysize", FieldType::Float, &EmitterNode::ysize, 100.0f, {0.1f}, OmitRule::IfNoGeometry},
+    {"colorStart", FieldType::Color, &EmitterNode::colorStart, 1.0f, {0.929f, 0.592f, 0.231f}},
+    {"colorMid", FieldType::Color, &EmitterNode::colorMid, 1.0f, {-1.0f, -1.0f, -1.0f}, OmitRule::IfDefault},
+    {"colorEnd", FieldType::Color, &EmitterNode::colorEnd, 1.0f, {0.910f, 0.471f, 0.0f}},
+    {"alphaStart", FieldType::Float, &EmitterNode::alphaStart, 1.0f, {1.0f}},
+    {"alphaMid", FieldType::Float, &EmitterNode::alphaMid, 1.0f, {-1.0f}, OmitRule::IfDefault},
+    {"alphaEnd", FieldType::Float, &EmitterNode::alphaEnd, 1.0f, {1.0f}},
+    {"sizeStart", FieldType::Float, &EmitterNode::sizeStart, 1.0f, {0.5f}},
+    {"sizeMid", FieldType::Float, &EmitterNode::sizeMid, 1.0f, {-1.0f}, OmitRule::IfDefault},
+    {"sizeEnd", FieldType::Float, &EmitterNode::sizeEnd},
+    {"sizeStart_y", FieldType::Float, &EmitterNode::sizeStart_y},
+    {"sizeMid_y", FieldType::Float, &EmitterNode::sizeMid_y, 1.0f, {-1.0f}, OmitRule::IfDefault},
+    {"sizeEnd_y", FieldType::Float, &EmitterNode::sizeEnd_y},
+    {"percentStart", FieldType::Float, &EmitterNode::percentStart, 1.0f, {0.0f}, OmitRule::IfDefault},
+    {"percentMid", FieldType::Float, &EmitterNode::percentMid, 1.0f, {0.5f}, OmitRule::IfDefault},
+    {"percentEnd", FieldType::Float, &EmitterNode::percentEnd, 1.0f, {1.0f}, OmitRule::IfDefault},
+    {"birthrate", FieldType::Float, &EmitterNode::birthrate, 1.0f, {2.0f}},
+    {"lifeExp", FieldType::Float, &EmitterNode::lifeExp, 1.0f, {1.5f}},
+    {"mass", FieldType::Float, &EmitterNode::mass, 1.0f, {1.0f}},
+    {"spread", FieldType::Float, &EmitterNode::spread, 1.0f, {45.0f}},
+    {"particleRot", FieldType::Float, &EmitterNode::particleRot},
+    {"velocity", FieldType::Float, &EmitterNode::velocity, 1.0f, {1.0f}},
+    {"grav", FieldType::Float, &EmitterNode::grav, 1.0f, {}, OmitRule::IfZero},
+    {"drag", FieldType::Float, &EmitterNode::drag, 1.0f, {}, OmitRule::IfZero},
+    {"threshold", FieldType::Float, &EmitterNode::threshold, 1.0f, {}, OmitRule::IfZero},
+    {"fps", FieldType::Float, &EmitterNode::fps, 1.0f, {}, OmitRule::IfZero},
+    {"frameStart", FieldType::Float, &EmitterNode::frameStart, 1.0f, {}, OmitRule::IfZero},
+    {"frameEnd", FieldType::Float, &EmitterNode::frameEnd, 1.0f, {}, OmitRule::IfZero},
+    {"bounce_co", FieldType::Float, &EmitterNode::bounce_co, 1.0f, {}, OmitRule::IfZero},
+    {"combinetime", FieldType::Float, &EmitterNode::combinetime, 1.0f, {}, OmitRule::IfZero},
+    {"blurlength", FieldType::Float, &EmitterNode::blurlength, 1.0f, {}, OmitRule::IfZero},
+    {"lightningDelay", FieldType::Float, &EmitterNode::lightningDelay, 1.0f, {}, OmitRule::IfZero},
+    {"lightningRadius", FieldType::Float, &EmitterNode::lightningRadius, 1.0f, {}, OmitRule::IfZero},
+    {"lightningScale", FieldType::Float, &EmitterNode::lightningScale, 1.0f, {}, OmitRule::IfZero},
+    {"lightningSubDiv", FieldType::Float, &EmitterNode::lightningSubDiv, 1.0f, {}, OmitRule::IfZero},
+    {"lightningZigZag", FieldType::Float, &EmitterNode::lightningZigZag, 1.0f, {}, OmitRule::IfZero},
+});
+
+// Look up a field by its MDL keyword, returns nullptr for unknown tokens
+const EmitterField* findEmitterField(std::string_view name);
+
+// Reset every table field of an emitter to its default value
+void applyEmitterFieldDefaults(EmitterNode& emitter);
+
+// Parse the value(s) following a field keyword; returns false if the stream did not contain a valid value
+bool parseEmitterField(const EmitterField& field, EmitterNode& emitter, std::istream& in);
+
+bool isEmitterFieldOmitted(const EmitterField& field, const EmitterNode& emitter);
+
+// Append "  <name> <value>\n" unless the field's omit rule applies
+void writeEmitterField(const EmitterField& field, const EmitterNode& emitter, std::string& out);
+
+bool emitterFieldEquals(const EmitterField& field, const EmitterNode& a, const EmitterNode& b);
+
+// Fields whose values differ between two emitters
+std::vector<const EmitterField*> diffEmitterFields(const EmitterNode& a, const EmitterNode& b);
+
+// Hash over all table fields (name and animation keys are not included)
+size_t hashEmitterFields(const EmitterNode& emitter);
+
+#endif // EMITTER_FIELDS_HPP
@@ -22,6 +22,7 @@
 #include <filesystem>
 #include <string>
 #include <vector>
+#include "texture_index.hpp"
 
 class FileDialog
 {
@@ -29,7 +30,9 @@ public:
     static bool renderLoadDialog(const char* label, std::string& selectedFile);
     static bool renderSaveDialog(const char* label, std::string& filename);
     static bool renderSaveAsDialog(const char* label, std::string& filename, const std::string& currentPath);
-    static bool renderTextureDialog(const char* label, std::string& selectedTexture);
+    // Lists textures from index while browsing its directory, other directories are indexed on demand
+    static bool renderTextureDialog(const char* label, std::string& selectedTexture,
+                                    const TextureIndex* index = nullptr);
     static std::string extractModelName(const std::string& filename);
     static void setLastSavedFilename(const std::string& filename);
     static void clearFileCache();
@@ -41,12 +44,12 @@ private:
     static std::string searchFilter;
     static std::vector<std::filesystem::path> cachedDirectoryContents;
     static bool filesLoaded;
+    static TextureIndex browsedTextures;
 
     static void navigateToPath(const std::string& path);
     static std::vector<std::filesystem::path> getDirectoryContents();
     static std::vector<std::filesystem::path> getFilteredDirectoryContents();
     static bool isValidMDLFilename(const std::string& filename);
-    static bool isValidTextureFile(const std::string& filename);
     static bool matchesFilter(const std::string& filename);
 };
 
@@ -0,0 +1,75 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef FILE_WATCHER_HPP
+#define FILE_WATCHER_HPP
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// Reports files that were written, renamed into place or deleted. Uses inotify on Linux and falls back to comparing
+// modification times about once per poll interval where inotify is unavailable.
+class FileWatcher
+{
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Every file directly inside the directory
+    void watchDirectory(const std::string& directory);
+
+    // A single file, watched through its parent directory so editors that save by renaming are seen too
+    void watchFile(const std::string& path);
+
+    void clear();
+
+    // Paths changed since the last call, without duplicates. Never blocks.
+    std::vector<std::string> poll();
+
+    void setPollInterval(std::chrono::milliseconds interval) { pollInterval = interval; }
+
+private:
+    struct Directory
+    {
+        int watch = -1; // inotify watch descriptor, -1 while the directory is polled
+        bool allFiles = false;
+        std::set<std::string> files; // Watched file names when not allFiles
+        std::map<std::string, std::filesystem::file_time_type> snapshot; // Polling only
+    };
+
+    Directory& addDirectory(const std::string& directory);
+    bool isWatched(const Directory& directory, const std::string& name) const;
+    void takeSnapshot(const std::string& path, Directory& directory);
+    void readEvents(std::set<std::string>& changed);
+    void pollDirectories(std::set<std::string>& changed);
+
+    std::map<std::string, Directory> directories;
+    int inotifyFd = -1;
+    std::chrono::milliseconds pollInterval{1000};
+    std::chrono::steady_clock::time_point lastPoll;
+};
+
+#endif // FILE_WATCHER_HPP
@@ -0,0 +1,40 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIGHTNING_HPP
+#define LIGHTNING_HPP
+
+#include <glm/glm.hpp>
+#include <random>
+#include <vector>
+
+struct LightningParams
+{
+    int zigZag = 0; // Random kinks along the straight path before subdividing
+    int subdivisions = 0; // Midpoint displacement passes, each doubles the point count
+    float scale = 0.0f; // Displacement relative to the length of the segment being split
+
+    bool operator==(const LightningParams&) const = default;
+};
+
+// Build a jagged polyline from start to end; points is overwritten, the endpoints are kept exactly
+void generateLightningBolt(const glm::vec3& start, const glm::vec3& end, const LightningParams& params,
+                           std::mt19937& rng, std::vector<glm::vec3>& points);
+
+#endif // LIGHTNING_HPP
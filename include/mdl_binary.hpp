@@ -0,0 +1,51 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MDL_BINARY_HPP
+#define MDL_BINARY_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "emitter.hpp"
+#include "model_node.hpp"
+
+// The parts of a compiled model the editor keeps
+struct BinaryModel
+{
+    std::string name;
+    std::vector<ModelNode> dummies; // In file order, the root first
+    std::vector<EmitterNode> emitters;
+    bool complete = true; // False if it also holds meshes, lights or animations, which are not read
+};
+
+// Compiled NWN model files start with a zero dword where ASCII files have text
+bool isBinaryMDL(const unsigned char* data, size_t size);
+
+// Read the dummy and emitter nodes of a compiled model directly from the file contents.
+// Returns false if the buffer is truncated or not a model geometry.
+bool readBinaryMDL(const unsigned char* data, size_t size, BinaryModel& model);
+
+// Compile the dummies and emitters under their parents. The parentless dummy is written as the root under
+// modelName, nodes whose parent is not found hang off the root. Returns an empty buffer if the keys of a
+// track do not fit the 16-bit controller indices.
+std::vector<unsigned char> writeBinaryMDL(const std::string& modelName, const std::vector<ModelNode>& dummies,
+                                          const std::vector<EmitterNode>& emitters);
+
+#endif // MDL_BINARY_HPP
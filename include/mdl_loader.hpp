@@ -0,0 +1,96 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MDL_LOADER_HPP
+#define MDL_LOADER_HPP
+
+#include <atomic>
+#include <functional>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "emitter.hpp"
+#include "resource_manager.hpp"
+
+// Parses an MDL file on a worker thread into its own EmitterEditor, the UI thread swaps it in when done
+class MDLLoader
+{
+public:
+    enum class Status
+    {
+        Idle,
+        Loading,
+        Succeeded,
+        Failed,
+        Cancelled
+    };
+
+    MDLLoader();
+    ~MDLLoader();
+
+    MDLLoader(const MDLLoader&) = delete;
+    MDLLoader& operator=(const MDLLoader&) = delete;
+
+    // Cancels any load in progress before starting the new one
+    void start(const std::string& filename);
+
+    // Parse a model straight from a mounted archive, name is shown in place of a file name
+    void start(const std::string& name, const ResourceManager::Resource& resource);
+    void cancel();
+
+    bool isLoading() const { return loading.load(std::memory_order_acquire); }
+
+    float getProgress() const;
+
+    const std::string& getFilename() const { return filename; }
+
+    // The last load read an archive resource rather than a file, so it can't be saved back in place
+    bool isFromArchive() const { return fromArchive; }
+
+    // Once the worker has finished, moves a successfully loaded model into target and returns the final status.
+    // Returns Loading while the worker is still running and Idle when there is nothing to collect.
+    Status collect(EmitterEditor& target);
+
+    // Texture names parsed since the last call, for prefetching while the rest of the file loads
+    std::vector<std::string> takeTextureNames();
+
+private:
+    void join();
+    void run(const std::string& name, uint64_t size, bool archive,
+             std::function<bool(EmitterEditor&, const MDLLoadObserver&)> load);
+
+    std::thread worker;
+    std::string filename;
+    uint64_t totalBytes = 0;
+    bool fromArchive = false;
+
+    std::atomic<bool> loading{false};
+    std::atomic<bool> cancelRequested{false};
+    std::atomic<uint64_t> bytesRead{0};
+
+    std::mutex mutex; // Guards the members below
+    std::unique_ptr<EmitterEditor> result;
+    Status status = Status::Idle;
+    std::vector<std::string> textureNames;
+};
+
+#endif // MDL_LOADER_HPP
@@ -0,0 +1,65 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MDL_TEXT_VIEW_HPP
+#define MDL_TEXT_VIEW_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "emitter.hpp"
+
+// Line-indexed view of the generated MDL text, only visible lines are submitted to ImGui
+class MDLTextView
+{
+public:
+    MDLTextView();
+    ~MDLTextView();
+
+    void render(const EmitterEditor& editor, bool* open);
+
+private:
+    struct EmitterLine
+    {
+        std::string name;
+        int line;
+    };
+
+    void rebuild(const EmitterEditor& editor);
+    void findMatches(const std::string& query);
+    void updateSearch();
+    void jumpToMatch(int direction);
+    std::string_view getLine(int line) const;
+
+    std::string text;
+    std::vector<size_t> lineOffsets; // Start of each line in text
+    std::vector<EmitterLine> emitterLines;
+    uint64_t builtRevision = UINT64_MAX;
+
+    char searchBuffer[128] = {};
+    std::string activeQuery;
+    std::vector<int> matches; // Line numbers containing activeQuery
+    int currentMatch = -1;
+
+    int scrollToLine = -1;
+    int highlightLine = -1;
+};
+
+#endif // MDL_TEXT_VIEW_HPP
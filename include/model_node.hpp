@@ -0,0 +1,53 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MODEL_NODE_HPP
+#define MODEL_NODE_HPP
+
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <string>
+
+// A non-emitter node (dummy, trimesh, light, ...) kept so the full model can be written back
+struct ModelNode
+{
+    std::string type;
+    std::string name;
+    std::string parent = "NULL";
+
+    // Parsed for placing children in the scene, the node's text is written back unchanged
+    glm::vec3 position = {0.0f, 0.0f, 0.0f};
+    glm::quat orientation = {1.0f, 0.0f, 0.0f, 0.0f};
+
+    std::string body; // Lines between the node header and endnode, without the parent line
+};
+
+// A newanim section, located on load and parsed only when selected
+struct ModelAnimation
+{
+    std::string name;
+    size_t bodyOffset = 0; // Byte offset of the line after newanim in the source file
+    size_t bodySize = 0; // Up to, not including, the doneanim line
+
+    bool parsed = false;
+    float length = 0.0f; // From the section's "length" line once parsed
+};
+
+#endif // MODEL_NODE_HPP
@@ -0,0 +1,72 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PARTICLE_GRADIENT_HPP
+#define PARTICLE_GRADIENT_HPP
+
+#include <array>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include "emitter.hpp"
+
+// An emitter's color, alpha and size over particle life, baked from its start/mid/end keys into a table
+class ParticleGradient
+{
+public:
+    static constexpr size_t resolution = 256;
+
+    struct Sample
+    {
+        glm::vec4 color; // rgb + alpha
+        glm::vec2 size; // size, size_y
+    };
+
+    // Rebake if any gradient key of the emitter changed; returns true when the table was rebuilt
+    bool update(const EmitterNode& emitter);
+
+    // lifeFraction is 0 at birth and 1 at death
+    const Sample& sample(float lifeFraction) const
+    {
+        float position = glm::clamp(lifeFraction, 0.0f, 1.0f) * static_cast<float>(resolution - 1);
+        return samples[static_cast<size_t>(position + 0.5f)];
+    }
+
+    const std::array<Sample, resolution>& getSamples() const { return samples; }
+
+private:
+    struct Keys
+    {
+        glm::vec3 colorStart, colorMid, colorEnd;
+        float alphaStart, alphaMid, alphaEnd;
+        float sizeStart, sizeMid, sizeEnd;
+        float sizeStart_y, sizeMid_y, sizeEnd_y;
+        float percentStart, percentMid, percentEnd;
+
+        bool operator==(const Keys&) const = default;
+    };
+
+    static Keys keysOf(const EmitterNode& emitter);
+    void bake();
+
+    Keys keys{};
+    bool baked = false;
+    std::array<Sample, resolution> samples{};
+};
+
+#endif // PARTICLE_GRADIENT_HPP
@@ -20,6 +20,7 @@
 #define PARTICLE_SYSTEM_HPP
 
 #include <glad/glad.h>
+#include <array>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <memory>
@@ -28,6 +29,10 @@
 #include <vector>
 #include "emitter.hpp"
 #include "grab_mode.hpp"
+#include "lightning.hpp"
+#include "particle_gradient.hpp"
+#include "scene_graph.hpp"
+#include "texture_streamer.hpp"
 
 struct Particle
 {
@@ -40,12 +45,14 @@ struct Particle
     float rotation;
     float mass;
     bool active;
+    bool splatted; // Landed on a collision plane, drawn as a decal facing splatNormal
+    glm::vec3 splatNormal;
 
     float getAge() const { return maxLife - life; }
 
     Particle() :
         position(0.0f), velocity(0.0f), color(1.0f), size(1.0f), life(0.0f), maxLife(1.0f), rotation(0.0f), mass(1.0f),
-        active(false)
+        active(false), splatted(false), splatNormal(0.0f, 0.0f, 1.0f)
     {
     }
 };
@@ -58,7 +65,34 @@ struct ParticleSystemState
     std::mt19937 rng;
     float animationTime;
 
-    ParticleSystemState() : lastSpawnTime(0.0f), maxParticles(500000), rng(std::random_device{}()), animationTime(0.0f)
+    // Explosion and Single emitters fire a burst when this is set
+    bool burstPending;
+
+    // Per-particle random numbers of the spawn in progress, kept to reuse the allocation
+    struct SpawnRandom
+    {
+        float x, y, spread, azimuth, speed;
+    };
+    std::vector<SpawnRandom> spawnRandoms;
+
+    // Emitter position at the last spawn, Trail emitters interpolate from it
+    glm::vec3 lastSpawnOrigin;
+    bool hasSpawnOrigin;
+
+    // Lightning bolt along the local Z axis, regenerated every lightningDelay seconds or when its shape changes.
+    // boltPoints is the cached bolt moved into world space each frame.
+    std::vector<glm::vec3> boltLocal;
+    std::vector<glm::vec3> boltPoints;
+    LightningParams boltParams;
+    float boltLength;
+    float boltTimer;
+
+    ParticleGradient gradient;
+    GLuint gradientTexture; // Color and alpha row of the gradient, owned by ParticleRenderer
+
+    ParticleSystemState() :
+        lastSpawnTime(0.0f), maxParticles(500000), rng(std::random_device{}()), animationTime(0.0f), burstPending(true),
+        lastSpawnOrigin(0.0f), hasSpawnOrigin(false), boltLength(0.0f), boltTimer(0.0f), gradientTexture(0)
     {
     }
 };
@@ -90,10 +124,55 @@ public:
     void setCamera(const glm::mat4& view, const glm::mat4& projection);
     void setTextureDirectory(const std::string& directory);
 
+    // Non-emitter nodes that emitters can be parented to
+    void setModelNodes(const std::vector<ModelNode>& nodes) { sceneGraph.setModelNodes(nodes); }
+
+    // Carry simulation state over a reload of the model. Emitters are matched by name; those whose fields did not
+    // change keep their particles, the others start over. Returns the number of emitters that were reset.
+    int reloadEmitters(const std::vector<EmitterNode>& previous, const std::vector<EmitterNode>& current);
+
+    // World-space position of an emitter as of the last rendered frame
+    glm::vec3 getEmitterWorldPosition(int emitterIndex) const;
+
+    // Convert a world-space offset from the viewport tools into the frame of an emitter's parent
+    glm::vec3 worldToParentOffset(int emitterIndex, const glm::vec3& offset) const;
+
+    // Rotation angles of an emitter at rotation after turning it by delta, Euler degrees about world axes.
+    // Composed as quaternions so the result does not drift; the scale of the parent does not apply.
+    glm::vec3 rotateInWorld(int emitterIndex, const glm::vec3& rotation, const glm::vec3& delta) const;
+
+    // Start streaming a texture ahead of first use so it is ready when an emitter references it
+    void prefetchTexture(const std::string& textureName) { textureStreamer.request(textureName); }
+
+    // Texture files of the current texture directory, shared with the texture picker
+    const TextureIndex& getTextureIndex() const { return textureStreamer.getTextureIndex(); }
+
+    // Archives that bare texture names fall back to when no loose file has them, must outlive the renderer
+    void setResourceManager(const ResourceManager* manager) { textureStreamer.setResourceManager(manager); }
+
+    // Directory that decoded textures are kept in between runs, empty to disable
+    void setTextureDiskCacheDirectory(const std::string& directory)
+    {
+        textureStreamer.setDiskCacheDirectory(directory);
+    }
+    const TextureDiskCache* getTextureDiskCache() const { return textureStreamer.getDiskCache(); }
+
+    void setTextureCacheBudget(size_t bytes) { textureStreamer.setCacheBudget(bytes); }
+    TextureCache::Stats getTextureCacheStats() const { return textureStreamer.getCacheStats(); }
+
     GLuint getFramebufferTexture() const { return colorTexture; }
 
     GLuint getFramebuffer() const { return framebuffer; }
 
+    // Baked color/alpha over particle life of an emitter, 0 until it has been rendered
+    GLuint getGradientTexture(int emitterIndex) const;
+
+    // Extra planes (normal xyz, offset w) that bouncing and splatting particles collide with, besides the ground
+    void setCollisionPlanes(const std::vector<glm::vec4>& planes);
+
+    // Replay the bursts of Explosion and Single emitters
+    void retrigger();
+
     int getActiveParticleCount(int emitterIndex) const;
     int getTotalActiveParticleCount() const;
 
@@ -125,13 +204,42 @@ private:
         glm::vec3 direction;
     };
 
+    // A block of moving particles gathered one array per component, so collision tests four particles per SSE2
+    // step. Blocks are small enough to be scattered back while their particles are still in cache.
+    struct CollisionBatch
+    {
+        static constexpr size_t capacity = 256;
+
+        std::array<uint32_t, capacity> particles{}; // Index into the pool
+        std::array<std::array<float, capacity>, 3> position{};
+        std::array<std::array<float, capacity>, 3> velocity{};
+        std::array<std::array<float, capacity>, 3> splatNormal{}; // Only meaningful where splatted is set
+        std::array<float, capacity> splatted{}; // 0 or 1, particles that landed in this block
+        size_t count = 0;
+
+        bool full() const { return count == capacity; }
+        void push(uint32_t index, const Particle& particle);
+        void collide(const glm::vec4& plane, float restitution, float deltaTime, bool splat);
+        void scatter(std::vector<Particle>& pool);
+    };
+
     Ray createRayFromMouse(float mouseX, float mouseY, int viewportWidth, int viewportHeight) const;
     bool rayIntersectsSphere(const Ray& ray, const glm::vec3& center, float radius, float& distance) const;
     bool rayIntersectsCone(const Ray& ray, const glm::vec3& apex, const glm::vec3& direction, float height, float angle,
                            float& distance) const;
-    void updateParticles(const EmitterNode& emitter, ParticleSystemState& state, float deltaTime);
-    void spawnParticle(const EmitterNode& emitter, ParticleSystemState& state, const glm::vec3& emitterPos);
+    void updateParticles(const EmitterNode& emitter, ParticleSystemState& state, const glm::mat4& world,
+                         float deltaTime);
+    void spawnParticles(const EmitterNode& emitter, ParticleSystemState& state, const glm::mat4& world,
+                        size_t count);
+    void collideParticles(const EmitterNode& emitter, ParticleSystemState& state, float deltaTime);
+    void updateLightning(const EmitterNode& emitter, ParticleSystemState& state, const glm::mat4& world,
+                         float deltaTime);
     void renderParticles(const EmitterNode& emitter, const ParticleSystemState& state);
+    void renderRibbon(const EmitterNode& emitter, const ParticleSystemState& state);
+    bool bindParticleTexture(const EmitterNode& emitter, GLuint program);
+    void applyParticleBlend(const EmitterNode& emitter);
+    void appendBoltVertices(const ParticleSystemState& state, std::vector<float>& vertexData) const;
+    void uploadGradientTexture(ParticleSystemState& state);
 
     GLuint shaderProgram;
     GLuint VAO, VBO;
@@ -140,6 +248,13 @@ private:
     GLuint lineShaderProgram;
     GLuint lineVAO, lineVBO;
 
+    // Linked ribbons, particle data is read from a buffer texture
+    GLuint ribbonShaderProgram = 0;
+    GLuint ribbonVAO = 0;
+    GLuint ribbonBuffer = 0;
+    GLuint ribbonTexture = 0;
+    std::vector<float> ribbonPoints;
+
     // Framebuffer for rendering to texture
     GLuint framebuffer;
     GLuint colorTexture;
@@ -151,28 +266,30 @@ private:
     float globalAnimationTime;
 
     std::vector<ParticleSystemState> emitterStates;
+    std::vector<glm::vec4> collisionPlanes;
+    CollisionBatch collisionBatch;
+    SceneGraph sceneGraph;
 
-    std::vector<GLuint> textures;
-    std::unordered_map<std::string, GLuint> textureCache;
-    std::string textureDirectory;
-
-    void loadTexture(const std::string& textureName);
-    GLuint getTexture(const std::string& textureName);
+    TextureStreamer textureStreamer;
+    static const std::string& getEmitterTextureName(const EmitterNode& emitter);
 
     const char* vertexShaderSource;
     const char* fragmentShaderSource;
     const char* lineVertexShaderSource;
     const char* lineFragmentShaderSource;
+    const char* ribbonVertexShaderSource;
 
     void createShaders();
     void createLineShaders();
+    void createRibbonShaders();
     void setupBuffers();
     void setupLineBuffers();
+    void setupRibbonBuffers();
     void setupFramebuffer(int width, int height);
     void cleanupFramebuffer();
 
     void renderDummyNode(const glm::vec3& position);
-    void renderEmitterNode(const EmitterNode& emitter, bool isSelected = false);
+    void renderEmitterNode(const EmitterNode& emitter, const glm::mat4& world, bool isSelected = false);
 };
 
 #endif // PARTICLE_SYSTEM_HPP
@@ -21,6 +21,7 @@
 
 #include <imgui.h>
 #include "emitter.hpp"
+#include "texture_index.hpp"
 
 class PropertyEditor
 {
@@ -32,11 +33,19 @@ public:
     bool hasChanges() const { return propertiesChanged; }
     void resetChangeFlag() { propertiesChanged = false; }
 
+    // Baked color/alpha gradient of the selected emitter, drawn as a preview strip
+    void setGradientTexture(ImTextureID texture) { gradientTexture = texture; }
+
+    // Index of the texture directory, lets the texture picker list it without scanning again
+    void setTextureIndex(const TextureIndex* index) { textureIndex = index; }
+
 private:
     void renderOutliner(EmitterEditor& editor, int& selectedEmitter);
-    void renderEmitterProperties(EmitterNode& emitter);
+    void renderEmitterProperties(EmitterEditor& editor, int index);
 
     bool propertiesChanged;
+    ImTextureID gradientTexture = 0;
+    const TextureIndex* textureIndex = nullptr;
 
     void renderEnumCombo(const char* label, int& value, const char* const* items, int itemCount);
     void renderUpdateTypeCombo(UpdateType& updateType);
@@ -45,6 +54,8 @@ private:
     void renderSpawnTypeCombo(SpawnType& spawnType);
 
     bool renderColorEdit(const char* label, glm::vec3& color);
+    bool renderOptionalColorEdit(const char* label, glm::vec3& color, const glm::vec3& fallback);
+    bool renderOptionalFloat(const char* label, float& value, float fallback, float speed);
     bool renderVec3Edit(const char* label, glm::vec3& vec);
     bool renderQuatEdit(const char* label, glm::quat& quat);
     bool renderEditableFloat(const char* label, float& value, float speed = 0.1f, float min = 0.0f, float max = 0.0f);
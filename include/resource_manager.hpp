@@ -0,0 +1,117 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef RESOURCE_MANAGER_HPP
+#define RESOURCE_MANAGER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "mapped_file.hpp"
+
+// Resource type ids used by ERF and KEY/BIF files
+enum class ResourceType : uint16_t
+{
+    TGA = 3,
+    MDL = 2002,
+    DDS = 2033
+};
+
+// Game resources inside memory-mapped ERF/HAK/MOD archives and KEY/BIF data, looked up by resref.
+// Archives mounted later override earlier ones, as haks override the base game.
+// Must be used on one thread, resources that were handed out stay mapped after their archive is unmounted.
+class ResourceManager
+{
+public:
+    struct Resource
+    {
+        std::shared_ptr<const MappedFile> file; // Keeps data mapped
+        const unsigned char* data = nullptr;
+        size_t size = 0;
+        std::string location; // "<archive path>:<resref>.<ext>", unique among mounted archives
+        int64_t time = 0; // Modification time of the archive file when it was mounted, 0 if unknown
+
+        explicit operator bool() const { return data != nullptr; }
+    };
+
+    struct Mount
+    {
+        std::string path;
+        size_t resourceCount = 0;
+    };
+
+    // Mount an .erf, .hak, .mod or .nwm archive, or a .key file together with the BIFs it lists.
+    // Returns false and leaves the mounts unchanged if the file can't be read.
+    bool mount(const std::string& path);
+    void unmount(size_t index);
+    void clear();
+
+    const std::vector<Mount>& getMounts() const { return mounts; }
+
+    // Case-insensitive, an empty Resource if no mounted archive has it
+    Resource find(std::string_view resref, ResourceType type) const;
+
+    // Resrefs of every resource of a type, sorted
+    std::vector<std::string> list(ResourceType type) const;
+
+    // Bumped whenever the set of mounted archives changes
+    uint64_t getRevision() const { return revision; }
+
+    static const char* getExtension(ResourceType type);
+
+private:
+    struct Entry
+    {
+        std::string resref; // Lowercase
+        uint16_t type;
+        uint32_t file; // Index into the archive's files
+        size_t offset;
+        size_t size;
+    };
+
+    struct Archive
+    {
+        std::vector<std::shared_ptr<const MappedFile>> files; // The archive, or the BIFs of a KEY
+        std::vector<std::string> filePaths;
+        std::vector<int64_t> fileTimes;
+        std::vector<Entry> entries;
+    };
+
+    struct Location
+    {
+        uint32_t archive;
+        uint32_t entry;
+    };
+
+    static bool readERF(const std::string& path, Archive& archive);
+    static bool readKEY(const std::string& path, Archive& archive);
+    static void addFile(Archive& archive, std::shared_ptr<const MappedFile> file, const std::string& path);
+    void rebuildIndex();
+
+    std::vector<Mount> mounts;
+    std::vector<Archive> archives; // Parallel to mounts
+    std::unordered_map<std::string, Location> index; // By lowercase resref and type
+    uint64_t revision = 0;
+};
+
+#endif // RESOURCE_MANAGER_HPP
@@ -0,0 +1,100 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SCENE_GRAPH_HPP
+#define SCENE_GRAPH_HPP
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "emitter.hpp"
+#include "model_node.hpp"
+
+// Resolves the parent chains of model nodes and emitters into cached world matrices.
+// Only nodes whose local transform changed, and their descendants, are recomputed by update().
+class SceneGraph
+{
+public:
+    void setModelNodes(const std::vector<ModelNode>& modelNodes);
+
+    // Sync emitter transforms at the given animation time and refresh dirty world matrices
+    void update(const std::vector<EmitterNode>& emitters, float time);
+
+    const glm::mat4& getEmitterWorld(size_t index) const { return nodes[modelNodeCount + index].world; }
+    glm::vec3 getEmitterWorldPosition(size_t index) const { return glm::vec3(getEmitterWorld(index)[3]); }
+    glm::mat3 getEmitterWorldRotation(size_t index) const { return glm::mat3(getEmitterWorld(index)); }
+
+    // World matrix of the node an emitter's local transform is relative to
+    glm::mat4 getEmitterParentWorld(size_t index) const;
+    size_t getEmitterCount() const { return nodes.size() - modelNodeCount; }
+
+    // World positions of dummy model nodes, for drawing
+    std::vector<glm::vec3> getDummyPositions() const;
+
+private:
+    struct Node
+    {
+        std::string name;
+        std::string parentName;
+        bool isDummy = false;
+        int parent = -1;
+
+        glm::vec3 position = glm::vec3(0.0f);
+        glm::vec3 rotationAngles = glm::vec3(0.0f); // Emitters only, compared to detect edits
+        glm::quat orientation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        AnimationCursor positionCursor;
+        AnimationCursor orientationCursor;
+        bool orientationAnimated = false;
+
+        glm::mat4 local = glm::mat4(1.0f);
+        glm::mat4 world = glm::mat4(1.0f);
+        bool dirty = true;
+    };
+
+    // Orientation keys gathered for one SIMD nlerp pass, as structure of arrays
+    struct OrientationBatch
+    {
+        std::vector<uint32_t> emitters;
+        std::array<std::vector<float>, 4> from; // x y z w, overwritten with the result
+        std::array<std::vector<float>, 4> to;
+        std::vector<float> weight;
+
+        void clear();
+        void push(uint32_t emitter, const glm::quat& a, const glm::quat& b, float t);
+        glm::quat result(size_t index) const
+        {
+            return glm::quat(from[3][index], from[0][index], from[1][index], from[2][index]);
+        }
+        void evaluate();
+    };
+
+    bool syncStructure(const std::vector<EmitterNode>& emitters);
+    void gatherOrientations(const std::vector<EmitterNode>& emitters, float time);
+    void resolveParents();
+
+    std::vector<Node> nodes; // Model nodes first, then one per emitter
+    std::vector<int> order; // Parents before children
+    size_t modelNodeCount = 0;
+    OrientationBatch orientationBatch;
+};
+
+#endif // SCENE_GRAPH_HPP
@@ -23,6 +23,36 @@
 extern "C" {
 #endif
 
+#define STBI_DDS_MAX_LEVELS 16
+
+// Block-compressed contents of a DDS file, for uploading to the GPU without decoding
+typedef struct
+{
+    int width;
+    int height;
+    int fourcc; // 1, 3 or 5 for DXT1, DXT3 and DXT5
+    int channels; // 3 for DXT1, 4 for DXT3/DXT5
+    unsigned char const* blocks; // Level 0 blocks, pointing into the parsed buffer
+    int size; // Byte size of level 0
+    int levels; // Stored mip levels that are complete in the buffer, at least 1
+    int level_offsets[STBI_DDS_MAX_LEVELS]; // Byte offset of each level from blocks
+} stbi_dds_compressed;
+
+// Returns 0 if the buffer is not a supported DXT1/3/5 DDS file or is truncated
+int stbi_dds_parse_memory(unsigned char const* buffer, int len, stbi_dds_compressed* out);
+
+// Size and blocks of one stored mip level, returns 0 for levels past dds->levels
+int stbi_dds_get_level(stbi_dds_compressed const* dds, int level, int* width, int* height,
+                       unsigned char const** blocks, int* size);
+
+// Decode one stored mip level into caller memory of width * height * output_channels bytes
+int stbi_dds_decode_level_into(stbi_dds_compressed const* dds, int level, unsigned char* output,
+                               int output_channels);
+
+// Decode one stored mip level, the result is freed with free()
+unsigned char* stbi_dds_decode_level(stbi_dds_compressed const* dds, int level, int* x, int* y,
+                                     int desired_channels);
+
 unsigned char* stbi_load_dds_from_memory(unsigned char const* buffer, int len, int* x, int* y, int* channels_in_file,
                                          int desired_channels);
 unsigned char* stbi_load_dds(char const* filename, int* x, int* y, int* channels_in_file, int desired_channels);
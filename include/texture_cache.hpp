@@ -0,0 +1,109 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TEXTURE_CACHE_HPP
+#define TEXTURE_CACHE_HPP
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// GPU textures by name with a byte budget. Textures referenced by emitters are kept, the others are evicted
+// least recently used first once the budget is exceeded. Must be used on the GL thread.
+class TextureCache
+{
+public:
+    enum class State
+    {
+        Loading,
+        Resident,
+        Missing // No file found, retried once the texture directory changes
+    };
+
+    struct Entry
+    {
+        GLuint texture = 0;
+        State state = State::Loading;
+        size_t gpuBytes = 0;
+        int references = 0; // Emitters using this texture
+        uint64_t lastUsed = 0; // Frame of the last lookup
+        uint64_t lookupRunEnd = 0; // Frame after the last lookup, 0 before the first one
+        uint64_t directoryGeneration = 0; // Directory a Missing entry was looked up in
+        std::string path; // File a Resident entry was loaded from
+        uint64_t residentSequence = 0; // Of the decode that is resident, older results are dropped
+    };
+
+    struct Stats
+    {
+        size_t entries = 0;
+        size_t resident = 0;
+        size_t bytes = 0;
+        size_t budget = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+
+        float getHitRate() const { return hits + misses ? static_cast<float>(hits) / (hits + misses) : 0.0f; }
+    };
+
+    Entry* find(const std::string& key);
+    Entry& insert(const std::string& key); // New entries start out Loading
+
+    void setResident(Entry& entry, GLuint texture, size_t gpuBytes);
+    void setMissing(Entry& entry, uint64_t directoryGeneration);
+
+    // Mark the entry as used this frame. Lookups on consecutive frames are one use of the texture, only the first
+    // of a run counts for the hit rate: a hit if it was resident, a miss if it had to be loaded.
+    void recordLookup(Entry& entry, bool hit);
+
+    // Replace all reference counts with the textures the current emitters use
+    void setReferences(const std::vector<std::string>& keys);
+
+    template <typename Function>
+    void forEach(Function&& function)
+    {
+        for (auto& [key, entry] : entries)
+        {
+            function(key, entry);
+        }
+    }
+
+    // Advance the LRU clock and evict unreferenced textures while over budget
+    void endFrame();
+
+    // Delete every texture, statistics are kept
+    void clear();
+
+    void setBudget(size_t bytes) { budget = bytes; }
+    size_t getBudget() const { return budget; }
+
+    Stats getStats() const;
+
+private:
+    std::unordered_map<std::string, Entry> entries;
+    size_t residentBytes = 0;
+    size_t budget = 256 * 1024 * 1024;
+    uint64_t frame = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+};
+
+#endif // TEXTURE_CACHE_HPP
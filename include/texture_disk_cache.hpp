@@ -0,0 +1,100 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TEXTURE_DISK_CACHE_HPP
+#define TEXTURE_DISK_CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "mapped_file.hpp"
+
+// GPU-ready copies of decoded textures in a directory, one blob file per source. A blob is used while the size and
+// modification time of its source match, its content hash lets a background check catch changes those miss.
+// Blobs are memory-mapped and their levels uploaded as stored. The directory is kept under a byte budget by
+// deleting the least recently used blobs. Safe to use from several threads.
+class TextureDiskCache
+{
+public:
+    // Size and modification time of a source file, time is 0 for sources without one
+    struct Stamp
+    {
+        uint64_t size = 0;
+        int64_t time = 0;
+    };
+
+    struct Level
+    {
+        int width;
+        int height;
+        size_t offset; // From data
+        size_t size;
+    };
+
+    struct Blob
+    {
+        uint32_t format = 0; // GL format of the levels
+        bool compressed = false; // S3TC blocks rather than pixels
+        int width = 0;
+        int height = 0;
+        uint64_t contentHash = 0; // hashContent() of the source file
+        std::vector<Level> levels;
+        const unsigned char* data = nullptr;
+        size_t dataSize = 0;
+        std::shared_ptr<const MappedFile> file; // Set by load(), backs data
+    };
+
+    static constexpr uint64_t defaultBudget = 1024ull * 1024 * 1024;
+
+    explicit TextureDiskCache(std::string directory, uint64_t budget = defaultBudget);
+
+    const std::string& getDirectory() const { return directory; }
+    uint64_t getBudget() const { return budget; }
+
+    // Map the blob stored for a source if its stamp still matches
+    bool load(const std::string& source, const Stamp& stamp, Blob& blob) const;
+
+    // Write the blob for a source, replacing the previous one. Prunes the directory once enough has been written.
+    bool store(const std::string& source, const Stamp& stamp, const Blob& blob) const;
+
+    // Delete the least recently used blobs until the directory is well under the budget
+    void prune() const;
+
+    // Delete every blob in the directory
+    void clear() const;
+
+    static uint64_t hashContent(const unsigned char* data, size_t size);
+
+    // Per-user cache location for this application
+    static std::string getDefaultDirectory();
+
+private:
+    std::string getBlobPath(const std::string& source) const;
+
+    std::string directory;
+    uint64_t budget;
+    mutable std::atomic<uint64_t> bytesSincePrune{0};
+    mutable std::mutex pruneMutex;
+};
+
+#endif // TEXTURE_DISK_CACHE_HPP
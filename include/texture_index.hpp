@@ -0,0 +1,76 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TEXTURE_INDEX_HPP
+#define TEXTURE_INDEX_HPP
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Texture file types, in the order a name is resolved when several files share it
+enum class TextureFormat
+{
+    DDS,
+    TGA,
+    PNG,
+    JPG,
+    None
+};
+
+// Texture files of one directory by case-insensitive name, so bare texture names resolve with a hash lookup
+// instead of probing every extension on disk. Not thread safe.
+class TextureIndex
+{
+public:
+    struct Texture
+    {
+        std::string name; // File name of the best path without extension, as on disk
+        std::vector<std::string> paths; // Every file with this name, best format first
+    };
+
+    // Replace the index with the texture files directly inside directory
+    void scan(const std::string& directory);
+
+    // Add, update or drop a single file after it changed on disk, paths outside the directory are ignored
+    void fileChanged(const std::string& path);
+
+    void clear();
+
+    const std::string& getDirectory() const { return directory; }
+
+    // Case-insensitive, nullptr if no file has this name
+    const Texture* find(std::string_view name) const;
+
+    // All textures sorted by name
+    const std::vector<const Texture*>& getTextures() const;
+
+    static TextureFormat getFormat(std::string_view filename);
+
+private:
+    void addFile(const std::string& path);
+
+    std::string directory;
+    std::unordered_map<std::string, Texture> textures; // By lowercase name
+    mutable std::vector<const Texture*> sorted;
+    mutable bool sortedValid = false;
+};
+
+#endif // TEXTURE_INDEX_HPP
@@ -0,0 +1,171 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TEXTURE_STREAMER_HPP
+#define TEXTURE_STREAMER_HPP
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "file_watcher.hpp"
+#include "mapped_file.hpp"
+#include "resource_manager.hpp"
+#include "texture_cache.hpp"
+#include "texture_disk_cache.hpp"
+#include "texture_index.hpp"
+
+// Decodes textures on the shared thread pool and uploads them on the GL thread through a pixel buffer object,
+// a limited number of bytes per frame. Until a texture is resident, get() returns a neutral placeholder.
+// Files that change on disk are decoded again and replace the resident texture once they are uploaded.
+// With a disk cache set, decoded textures are kept there and mapped back instead of decoded on the next start.
+class TextureStreamer
+{
+public:
+    TextureStreamer() = default;
+    ~TextureStreamer() = default;
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // Creates the placeholder and upload buffer and checks for S3TC support, needs a current GL context
+    void initialize();
+    void cleanup();
+
+    // Directory that bare texture names are resolved against when their decode starts. It is indexed once here
+    // and kept current as files change. Changing it lets names that were not found before be looked up again.
+    void setTextureDirectory(const std::string& directory);
+
+    const TextureIndex& getTextureIndex() const { return textureIndex; }
+
+    // Archives searched for bare names that are not loose files in the texture directory, may be null.
+    // The manager must outlive the streamer; mounting or unmounting re-resolves the affected textures.
+    void setResourceManager(const ResourceManager* manager) { resources = manager; }
+
+    // Directory for decoded texture blobs, created if needed. An empty path disables the disk cache.
+    void setDiskCacheDirectory(const std::string& directory);
+
+    // The disk cache in use, null while it is disabled
+    const TextureDiskCache* getDiskCache() const { return diskCache.get(); }
+
+    // Start decoding a texture unless it is already loading or loaded
+    void request(const std::string& textureNameOrPath);
+
+    // The resident texture, the placeholder while it is still loading, or 0 if it could not be loaded
+    GLuint get(const std::string& textureNameOrPath);
+
+    // Textures the current emitters use, these are never evicted from the cache
+    void setReferencedTextures(const std::vector<std::string>& textureNames);
+
+    // Reload changed files, then upload finished decodes until this frame's byte budget is used up,
+    // at least one per call
+    void update();
+
+    // Evict unused textures over the cache budget, call once per frame after rendering
+    void endFrame() { cache.endFrame(); }
+
+    void setUploadBudget(size_t bytes) { uploadBudget = bytes; }
+
+    void setCacheBudget(size_t bytes) { cache.setBudget(bytes); }
+    TextureCache::Stats getCacheStats() const { return cache.getStats(); }
+
+private:
+    struct Level
+    {
+        int width;
+        int height;
+        size_t offset; // From data
+        size_t size;
+    };
+
+    // A file to decode: a loose file opened by the worker, or a resource inside an already mapped archive
+    struct Source
+    {
+        std::string path; // File path, or the archive location of resource
+        ResourceManager::Resource resource;
+        TextureFormat format;
+    };
+
+    // Result of a decode job, handed from a worker to the GL thread
+    struct Decoded
+    {
+        std::string key;
+        std::string path;
+        bool archived = false; // Read from a mounted archive, which is not watched for changes
+        uint64_t generation = 0;
+        uint64_t sequence = 0; // Order of the submit() this answers, later requests are higher
+        bool loaded = false;
+        bool compressed = false; // DXT blocks straight from the mapped file
+        GLenum format = 0;
+        int width = 0;
+        int height = 0;
+        std::vector<Level> levels;
+        const unsigned char* data = nullptr;
+        size_t dataSize = 0;
+
+        bool fromDiskCache = false; // Mapped from a blob rather than decoded
+        uint64_t contentHash = 0; // Of the source, as recorded in the blob
+
+        std::shared_ptr<const MappedFile> file; // Backs data for archived compressed textures and disk cache blobs
+        // Backs decoded data, or the copied blocks of a loose compressed texture
+        std::unique_ptr<unsigned char, decltype(&std::free)> pixels{nullptr, &std::free};
+    };
+
+    struct ReadyQueue
+    {
+        std::mutex mutex;
+        std::deque<Decoded> decoded;
+    };
+
+    std::vector<Source> resolve(const std::string& key) const;
+    void submit(const std::string& key, bool allowCompressed);
+    static void decode(Decoded& result, const std::vector<Source>& sources, bool allowCompressed,
+                       const TextureDiskCache* diskCache, bool readDiskCache = true);
+    static bool hashSource(const Source& source, uint64_t& hash);
+    static bool getStamp(const Source& source, TextureDiskCache::Stamp& stamp);
+    static void store(const TextureDiskCache& diskCache, const Source& source, const TextureDiskCache::Stamp& stamp,
+                      uint64_t contentHash, const Decoded& decoded);
+    GLuint upload(const Decoded& decoded);
+    void reloadChangedFiles();
+    void reloadArchiveTextures();
+
+    std::shared_ptr<ReadyQueue> readyQueue = std::make_shared<ReadyQueue>();
+    TextureCache cache;
+    FileWatcher watcher;
+    TextureIndex textureIndex;
+    const ResourceManager* resources = nullptr;
+    std::shared_ptr<const TextureDiskCache> diskCache; // Shared with decode jobs still in flight
+    uint64_t resourceRevision = 0;
+    std::string textureDirectory;
+    uint64_t directoryGeneration = 0; // Bumped whenever textureDirectory changes
+    uint64_t generation = 0; // Bumped by cleanup() so decodes still in flight are dropped
+    uint64_t requestSequence = 0; // Bumped by every submit()
+
+    bool compressedTexturesSupported = false; // GL_EXT_texture_compression_s3tc
+    size_t uploadBudget = 16 * 1024 * 1024;
+    GLuint placeholderTexture = 0;
+    GLuint uploadBuffer = 0;
+};
+
+#endif // TEXTURE_STREAMER_HPP
@@ -17,6 +17,9 @@
  */
 
 #include "emitter.hpp"
+#include "emitter_fields.hpp"
+#include "mapped_file.hpp"
+#include "mdl_binary.hpp"
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
@@ -26,6 +29,215 @@
 #include <iostream>
 #include <sstream>
 
+namespace
+{
+    // Walks the lines of an in-memory MDL document without copying them
+    class LineReader
+    {
+    public:
+        explicit LineReader(std::string_view text) : text(text) {}
+
+        bool next(std::string_view& line)
+        {
+            if (pos >= text.size())
+                return false;
+
+            size_t end = text.find('\n', pos);
+            if (end == std::string_view::npos)
+                end = text.size();
+
+            line = text.substr(pos, end - pos);
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+
+            pos = end + 1;
+            return true;
+        }
+
+        // Offset of the next line to be read
+        size_t position() const { return std::min(pos, text.size()); }
+
+        void seek(size_t offset) { pos = offset; }
+
+        // Start of the next line whose first token is the given keyword, or the end of the text
+        size_t findLineStartingWith(std::string_view keyword) const
+        {
+            size_t found = pos;
+            while ((found = text.find(keyword, found)) != std::string_view::npos)
+            {
+                size_t lineStart = text.rfind('\n', found);
+                lineStart = lineStart == std::string_view::npos ? 0 : lineStart + 1;
+                bool onlyWhitespaceBefore = text.substr(lineStart, found - lineStart).find_first_not_of(" \t") ==
+                    std::string_view::npos;
+                size_t after = found + keyword.size();
+                bool wholeWord = after >= text.size() || std::isspace(static_cast<unsigned char>(text[after]));
+                if (lineStart >= pos && onlyWhitespaceBefore && wholeWord)
+                    return lineStart;
+                found = after;
+            }
+            return text.size();
+        }
+
+    private:
+        std::string_view text;
+        size_t pos = 0;
+    };
+
+    std::string_view firstToken(std::string_view line)
+    {
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string_view::npos)
+            return {};
+        size_t end = line.find_first_of(" \t", start);
+        return line.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+    }
+
+    // Bake a track at twice its average key rate, or drop its table
+    template <typename Track>
+    void bakeTrack(Track& track, bool bake)
+    {
+        if (!bake || track.keyframes.size() < EmitterEditor::bakeKeyThreshold)
+        {
+            track.unbake();
+            return;
+        }
+        float duration = track.keyframes.back().time - track.keyframes.front().time;
+        track.bake(duration / static_cast<float>(2 * (track.keyframes.size() - 1)));
+    }
+
+    // Copy of an animation body with node from renamed to to in node headers, parent and animroot lines
+    std::string renameAnimationNode(std::string_view body, std::string_view from, std::string_view to)
+    {
+        std::string out;
+        out.reserve(body.size());
+        size_t pos = 0;
+        while (pos < body.size())
+        {
+            size_t end = body.find('\n', pos);
+            end = end == std::string_view::npos ? body.size() : end + 1;
+            std::string_view line = body.substr(pos, end - pos);
+            pos = end;
+
+            // The name is the third token of node lines and the second of parent and animroot lines
+            std::string_view keyword = firstToken(line);
+            int nameToken = keyword == "node" ? 3 : (keyword == "parent" || keyword == "animroot") ? 2 : 0;
+            size_t start = std::string_view::npos;
+            size_t tokenEnd = 0;
+            for (int t = 0; t < nameToken; ++t)
+            {
+                start = line.find_first_not_of(" \t\r\n", tokenEnd);
+                if (start == std::string_view::npos)
+                    break;
+                tokenEnd = std::min(line.find_first_of(" \t\r\n", start), line.size());
+            }
+
+            if (start != std::string_view::npos && line.substr(start, tokenEnd - start) == from)
+            {
+                out.append(line.substr(0, start));
+                out.append(to);
+                out.append(line.substr(tokenEnd));
+            }
+            else
+            {
+                out.append(line);
+            }
+        }
+        return out;
+    }
+
+    // Reads the "time x y z" lines following a positionkey header
+    void readKeyframes(LineReader& reader, int numKeys, AnimationTrack& track)
+    {
+        track.clear();
+        std::string_view lineView;
+        for (int i = 0; i < numKeys && reader.next(lineView); ++i)
+        {
+            std::istringstream keyss{std::string(lineView)};
+            float time = 0.0f, x = 0.0f, y = 0.0f, z = 0.0f;
+            keyss >> time >> x >> y >> z;
+            track.keyframes.emplace_back(time, glm::vec3(x, y, z));
+        }
+    }
+
+    // Reads the "time x y z angle" axis-angle lines following an orientationkey header
+    void readKeyframes(LineReader& reader, int numKeys, QuaternionTrack& track)
+    {
+        track.clear();
+        std::string_view lineView;
+        for (int i = 0; i < numKeys && reader.next(lineView); ++i)
+        {
+            std::istringstream keyss{std::string(lineView)};
+            float time = 0.0f, x = 0.0f, y = 0.0f, z = 0.0f, angle = 0.0f;
+            keyss >> time >> x >> y >> z >> angle;
+
+            glm::vec3 axis(x, y, z);
+            glm::quat key(1.0f, 0.0f, 0.0f, 0.0f);
+            if (std::abs(angle) >= 0.001f && glm::length(axis) > 0.0f)
+            {
+                key = glm::angleAxis(angle, glm::normalize(axis));
+            }
+            track.keyframes.emplace_back(time, key);
+        }
+    }
+} // namespace
+
+void AnimationTrack::bake(float sampleInterval)
+{
+    baked.clear();
+    if (keyframes.size() < 2 || sampleInterval <= 0.0f)
+        return;
+
+    float start = keyframes.front().time;
+    float duration = keyframes.back().time - start;
+    if (duration <= 0.0f)
+        return;
+
+    // Cap the table so a tiny interval on a long track cannot exhaust memory
+    constexpr size_t maxSamples = 1 << 20;
+    size_t count = static_cast<size_t>(std::ceil(duration / sampleInterval)) + 1;
+    count = std::clamp<size_t>(count, 2, maxSamples);
+    float interval = duration / static_cast<float>(count - 1);
+
+    std::vector<glm::vec3> samples(count);
+    AnimationCursor cursor;
+    for (size_t i = 0; i < count; ++i)
+    {
+        samples[i] = getValueAtTime(start + static_cast<float>(i) * interval, cursor);
+    }
+
+    baked = std::move(samples);
+    bakedStart = start;
+    bakedInterval = interval;
+}
+
+void QuaternionTrack::bake(float sampleInterval)
+{
+    baked.clear();
+    if (keyframes.size() < 2 || sampleInterval <= 0.0f)
+        return;
+
+    float start = keyframes.front().time;
+    float duration = keyframes.back().time - start;
+    if (duration <= 0.0f)
+        return;
+
+    constexpr size_t maxSamples = 1 << 20;
+    size_t count = static_cast<size_t>(std::ceil(duration / sampleInterval)) + 1;
+    count = std::clamp<size_t>(count, 2, maxSamples);
+    float interval = duration / static_cast<float>(count - 1);
+
+    std::vector<glm::quat> samples(count);
+    AnimationCursor cursor;
+    for (size_t i = 0; i < count; ++i)
+    {
+        samples[i] = getValueAtTime(start + static_cast<float>(i) * interval, cursor);
+    }
+
+    baked = std::move(samples);
+    bakedStart = start;
+    bakedInterval = interval;
+}
+
 EmitterEditor::EmitterEditor()
 {
 // Initialize texture directory to home directory
@@ -45,29 +257,9 @@ EmitterEditor::~EmitterEditor() = default;
 
 EmitterNode EmitterEditor::createDefaultEmitter()
 {
+    // Defaults for a basic fire effect come from the field table; texture starts empty to show fallback rendering
     EmitterNode emitter;
-
-    // Set reasonable defaults for a basic fire effect
-    emitter.update = UpdateType::Fountain;
-    emitter.render = RenderType::Normal;
-    emitter.blend = BlendType::Lighten;
-    emitter.texture = ""; // Start with no texture to show fallback rendering
-    emitter.birthrate = 2.0f;
-    emitter.lifeExp = 1.5f;
-    emitter.velocity = 1.0f;
-    emitter.spread = 45.0f;
-    emitter.colorStart = {0.929f, 0.592f, 0.231f};
-    emitter.colorEnd = {0.910f, 0.471f, 0.0f};
-    emitter.sizeStart = 0.5f;
-    emitter.sizeEnd = 0.0f;
-
-    // Set emitter geometry to small rectangle
-    emitter.xsize = 0.1f;
-    emitter.ysize = 0.1f;
-
-    // Set emitter flat on ground (no rotation needed in right-handed Z-up system)
-    emitter.rotationAngles = glm::vec3(0.0f, 0.0f, 0.0f); // No rotation by default
-
+    applyEmitterFieldDefaults(emitter);
     return emitter;
 }
 
@@ -75,14 +267,25 @@ void EmitterEditor::addEmitter(const std::string& name)
 {
     EmitterNode emitter = createDefaultEmitter();
     emitter.name = name;
+    detachFromSource();
+    nameIndex.emplace(emitter.name, emitters.size());
     emitters.push_back(emitter);
+    emitterGenerations.push_back(bumpRevision());
 }
 
 void EmitterEditor::removeEmitter(int index)
 {
     if (index >= 0 && index < static_cast<int>(emitters.size()))
     {
+        detachFromSource();
         emitters.erase(emitters.begin() + index);
+        emitterGenerations.erase(emitterGenerations.begin() + index);
+        if (index < static_cast<int>(textBlocks.size()))
+        {
+            textBlocks.erase(textBlocks.begin() + index);
+        }
+        bumpRevision();
+        rebuildNameIndex(); // Every emitter after the removed one has shifted
     }
 }
 
@@ -135,17 +338,7 @@ void EmitterEditor::duplicateEmitter(int index)
         suffix++;
 
         // Check if this name already exists
-        bool nameExists = false;
-        for (const auto& emitter : emitters)
-        {
-            if (emitter.name == newName)
-            {
-                nameExists = true;
-                break;
-            }
-        }
-
-        if (!nameExists)
+        if (!nameIndex.contains(newName))
         {
             break;
         }
@@ -153,623 +346,776 @@ void EmitterEditor::duplicateEmitter(int index)
     while (suffix < 1000); // Safety limit
 
     duplicate.name = newName;
+    detachFromSource();
+    nameIndex.emplace(duplicate.name, emitters.size());
     emitters.push_back(duplicate);
+    emitterGenerations.push_back(bumpRevision());
+}
+
+void EmitterEditor::renameEmitter(int index, const std::string& name)
+{
+    if (index < 0 || index >= static_cast<int>(emitters.size()) || emitters[index].name == name)
+    {
+        return;
+    }
+
+    // Animations refer to the emitter by name
+    detachFromSource();
+    for (size_t i = 0; i < animationBodies.size(); ++i)
+    {
+        if (animationBodyLoaded[i])
+            animationBodies[i] = renameAnimationNode(animationBodies[i], emitters[index].name, name);
+    }
+
+    // Children follow their parent to the new name, unless they resolved to another emitter of the same name
+    std::string oldName = emitters[index].name;
+    bool ownsName = findEmitter(oldName) == index;
+    emitters[index].name = name;
+    // Another emitter may share the old or new name, so rebuild rather than patch the entry
+    rebuildNameIndex();
+    touchEmitter(index);
+
+    if (!ownsName)
+    {
+        return;
+    }
+    for (size_t i = 0; i < emitters.size(); ++i)
+    {
+        if (emitters[i].parent == oldName)
+        {
+            emitters[i].parent = name;
+            touchEmitter(static_cast<int>(i));
+        }
+    }
+    bool nodesChanged = false;
+    for (auto& node : nodes)
+    {
+        if (node.parent == oldName)
+        {
+            node.parent = name;
+            nodesChanged = true;
+        }
+    }
+    if (nodesChanged)
+    {
+        modelNodesRevision = bumpRevision();
+    }
+}
+
+void EmitterEditor::touchEmitter(int index)
+{
+    if (index < 0 || index >= static_cast<int>(emitterGenerations.size()))
+    {
+        return;
+    }
+
+    // A name edited in place through getEmitters() is finished as a rename, so lookups and animations follow it
+    auto indexed = nameIndex.find(emitters[index].name);
+    if (indexed == nameIndex.end() || indexed->second != static_cast<size_t>(index))
+    {
+        auto previous = std::find_if(nameIndex.begin(), nameIndex.end(),
+                                     [&](const auto& entry)
+                                     {
+                                         return entry.second == static_cast<size_t>(index) &&
+                                             entry.first != emitters[index].name;
+                                     });
+        if (previous != nameIndex.end())
+        {
+            std::string name = emitters[index].name;
+            emitters[index].name = previous->first;
+            renameEmitter(index, name);
+            return;
+        }
+        if (indexed == nameIndex.end())
+        {
+            // Renamed from a duplicate name the index did not hold, the old name is unknown
+            rebuildNameIndex();
+        }
+    }
+
+    detachFromSource();
+    emitterGenerations[index] = bumpRevision();
+}
+
+void EmitterEditor::detachFromSource()
+{
+    // Unsaved edits keep the model from being reloaded when its file changes, so everything still read from
+    // the file has to be in memory before then. Once per model, edits arrive every frame while dragging.
+    if (detached)
+        return;
+    detached = true;
+    readAnimationBodies();
+}
+
+int EmitterEditor::findEmitter(const std::string& name) const
+{
+    auto it = nameIndex.find(name);
+    return it != nameIndex.end() ? static_cast<int>(it->second) : -1;
+}
+
+void EmitterEditor::rebuildNameIndex()
+{
+    nameIndex.clear();
+    for (size_t i = 0; i < emitters.size(); ++i)
+    {
+        nameIndex.emplace(emitters[i].name, i); // First emitter wins for duplicate names
+    }
+}
+
+uint64_t EmitterEditor::bumpRevision()
+{
+    // Shared counter so a model swapped in from another editor never reuses a revision a view has cached
+    static std::atomic<uint64_t> nextRevision{1};
+    revision = nextRevision.fetch_add(1, std::memory_order_relaxed);
+    return revision;
+}
+
+void EmitterEditor::resetGenerations()
+{
+    emitterGenerations.assign(emitters.size(), bumpRevision());
+    textBlocks.clear();
 }
 
 void EmitterEditor::resetToNew()
 {
     emitters.clear();
+    nameIndex.clear();
+    emitterGenerations.clear();
+    textBlocks.clear();
+    clearModelData();
     modelName = "emitter_model";
     addEmitter("default_emitter");
 }
 
-void EmitterEditor::setModelName(const std::string& name) { modelName = name; }
-
-std::string updateTypeToString(UpdateType type)
+void EmitterEditor::setModelName(const std::string& name)
 {
-    switch (type)
+    if (name == modelName)
     {
-    case UpdateType::Fountain:
-        return "Fountain";
-    case UpdateType::Single:
-        return "Single";
-    case UpdateType::Explosion:
-        return "Explosion";
-    case UpdateType::Lightning:
-        return "Lightning";
-    default:
-        return "Fountain";
+        return;
     }
+
+    detachFromSource();
+    modelName = name;
+    // Every emitter block names the model as its parent
+    textBlocks.clear();
+    bumpRevision();
 }
 
-std::string renderTypeToString(RenderType type)
+const std::string& EmitterEditor::getEmitterText(size_t index) const
 {
-    switch (type)
+    if (textBlocks.size() != emitters.size())
     {
-    case RenderType::Normal:
-        return "Normal";
-    case RenderType::Linked:
-        return "Linked";
-    case RenderType::Billboard_to_Local_Z:
-        return "Billboard_to_Local_Z";
-    case RenderType::Billboard_to_World_Z:
-        return "Billboard_to_World_Z";
-    case RenderType::Aligned_to_World_Z:
-        return "Aligned_to_World_Z";
-    case RenderType::Aligned_to_Particle_Direction:
-        return "Aligned_to_Particle_Direction";
-    case RenderType::Motion_Blur:
-        return "Motion_Blur";
-    default:
-        return "Normal";
+        textBlocks.resize(emitters.size());
     }
-}
 
-std::string blendTypeToString(BlendType type)
-{
-    switch (type)
+    // Emitters added behind the editor's back have no generation and are always regenerated
+    uint64_t generation = index < emitterGenerations.size() ? emitterGenerations[index] : 0;
+    TextBlock& block = textBlocks[index];
+    if (generation == 0 || block.generation != generation)
     {
-    case BlendType::Normal:
-        return "Normal";
-    case BlendType::Punch_Through:
-        return "Punch-Through";
-    case BlendType::Lighten:
-        return "Lighten";
-    default:
-        return "Normal";
+        const EmitterNode& emitter = emitters[index];
+        block.text.clear();
+        block.text += "node emitter " + emitter.name + "\n";
+        block.text += "  parent " + resolveParent(emitter.parent) + "\n";
+
+        for (const auto& field : emitterFields)
+        {
+            writeEmitterField(field, emitter, block.text);
+        }
+
+        block.text += "endnode\n";
+        block.generation = generation;
     }
+
+    return block.text;
 }
 
-std::string EmitterEditor::generateMDLText() const
+const std::string& EmitterEditor::generateMDLText() const
 {
-    std::stringstream ss;
+    if (mdlTextRevision == revision)
+    {
+        return mdlText;
+    }
 
-    ss << "#MAXMODEL ASCII\n";
-    ss << "# model: " << modelName << "\n";
-    ss << "newmodel " << modelName << "\n";
-    ss << "setsupermodel " << modelName << " NULL\n";
-    ss << "classification effect\n";
-    ss << "setanimationscale 1\n";
-    ss << "#MAXGEOM ASCII\n";
-    ss << "beginmodelgeom " << modelName << "\n";
+    bool complete = true; // False while an animation could not be read, so it is tried again next time
+    mdlText.clear();
+    mdlText += "#MAXMODEL ASCII\n";
+    mdlText += "# model: " + modelName + "\n";
+    mdlText += "newmodel " + modelName + "\n";
+    mdlText += "setsupermodel " + modelName + " " + supermodel + "\n";
+    mdlText += "classification " + classification + "\n";
+    mdlText += "setanimationscale 1\n";
+    mdlText += "#MAXGEOM ASCII\n";
+    mdlText += "beginmodelgeom " + modelName + "\n";
 
-    // Root dummy node
-    ss << "node dummy " << modelName << "\n";
-    ss << "  parent NULL\n";
-    ss << "endnode\n";
+    if (nodes.empty())
+    {
+        // Root dummy node
+        mdlText += "node dummy " + modelName + "\n";
+        mdlText += "  parent NULL\n";
+        mdlText += "endnode\n";
+    }
+    else
+    {
+        // Nodes of a loaded model, written back as read apart from the model name
+        for (const auto& node : nodes)
+        {
+            mdlText += "node " + node.type + " " + exportNodeName(node.name) + "\n";
+            mdlText += "  parent " + (node.parent == "NULL" ? node.parent : exportNodeName(node.parent)) + "\n";
+            mdlText += node.body;
+            mdlText += "endnode\n";
+        }
+    }
 
     // Emitter nodes
-    for (const auto& emitter : emitters)
-    {
-        ss << "node emitter " << emitter.name << "\n";
-        ss << "  parent " << modelName << "\n";
-        ss << "  p2p " << (emitter.p2p ? 1 : 0) << "\n";
-        ss << "  p2p_sel " << emitter.p2p_sel << "\n";
-        ss << "  affectedByWind " << (emitter.affectedByWind ? 1 : 0) << "\n";
-        ss << "  m_isTinted " << (emitter.m_isTinted ? 1 : 0) << "\n";
-        ss << "  bounce " << (emitter.bounce ? 1 : 0) << "\n";
-        ss << "  random " << (emitter.random ? 1 : 0) << "\n";
-        ss << "  inherit " << (emitter.inherit ? 1 : 0) << "\n";
-        ss << "  inheritvel " << (emitter.inheritvel ? 1 : 0) << "\n";
-        ss << "  inherit_local " << (emitter.inherit_local ? 1 : 0) << "\n";
-        ss << "  splat " << (emitter.splat ? 1 : 0) << "\n";
-        ss << "  inherit_part " << (emitter.inherit_part ? 1 : 0) << "\n";
-        ss << "  renderorder " << emitter.renderorder << "\n";
-        ss << "  spawntype " << static_cast<int>(emitter.spawntype) << "\n";
-        ss << "  update " << updateTypeToString(emitter.update) << "\n";
-        ss << "  render " << renderTypeToString(emitter.render) << "\n";
-        ss << "  blend " << blendTypeToString(emitter.blend) << "\n";
-
-        if (!emitter.texture.empty())
-        {
-            ss << "  texture " << emitter.texture << "\n";
-        }
-
-        ss << "  xgrid " << emitter.xgrid << "\n";
-        ss << "  ygrid " << emitter.ygrid << "\n";
-        ss << "  loop " << (emitter.loop ? 1 : 0) << "\n";
-        ss << "  deadspace " << emitter.deadspace << "\n";
-        ss << "  twosidedtex " << (emitter.twosidedtex ? 1 : 0) << "\n";
-        ss << "  blastRadius " << emitter.blastRadius << "\n";
-        ss << "  blastLength " << emitter.blastLength << "\n";
-
-        // Convert position from editor (Z-up) to MDL (Y-up) coordinate system
-        // glm::vec3 mdlPosition = EmitterNode::convertGameToMDL(emitter.position);
-        glm::vec3 mdlPosition = emitter.position;
-        ss << "  position " << mdlPosition.x << " " << mdlPosition.y << " " << mdlPosition.z << "\n";
-
-        // Convert stored angles to quaternion, then to axis-angle for MDL
-        glm::quat quat = glm::quat(glm::radians(emitter.rotationAngles));
-        float angle = glm::angle(quat);
-
-        if (angle < 0.001f)
-        {
-            // No rotation
-            ss << "  orientation 0.0 0.0 1.0 0.0\n";
-        }
-        else
-        {
-            // Get normalized axis from quaternion
-            glm::vec3 axis = glm::axis(quat);
-            // Save as X Z Y (our Z is up), angle already in radians
-            ss << "  orientation " << axis.x << " " << axis.y << " " << axis.z << " " << angle << "\n";
-        }
-
-        if (emitter.xsize > 0 || emitter.ysize > 0)
-        {
-            ss << "  xsize " << (emitter.xsize * 100.0f) << "\n";
-            ss << "  ysize " << (emitter.ysize * 100.0f) << "\n";
-        }
-
-        ss << "  colorStart " << emitter.colorStart.r << " " << emitter.colorStart.g << " " << emitter.colorStart.b
-           << "\n";
-        ss << "  colorEnd " << emitter.colorEnd.r << " " << emitter.colorEnd.g << " " << emitter.colorEnd.b << "\n";
-        ss << "  alphaStart " << emitter.alphaStart << "\n";
-        ss << "  alphaEnd " << emitter.alphaEnd << "\n";
-        ss << "  sizeStart " << emitter.sizeStart << "\n";
-        ss << "  sizeEnd " << emitter.sizeEnd << "\n";
-        ss << "  sizeStart_y " << emitter.sizeStart_y << "\n";
-        ss << "  sizeEnd_y " << emitter.sizeEnd_y << "\n";
-
-        ss << "  birthrate " << emitter.birthrate << "\n";
-        ss << "  lifeExp " << emitter.lifeExp << "\n";
-        ss << "  mass " << emitter.mass << "\n";
-        ss << "  spread " << emitter.spread << "\n";
-        ss << "  particleRot " << emitter.particleRot << "\n";
-        ss << "  velocity " << emitter.velocity << "\n";
-
-        if (emitter.grav != 0.0f)
-            ss << "  grav " << emitter.grav << "\n";
-        if (emitter.drag != 0.0f)
-            ss << "  drag " << emitter.drag << "\n";
-        if (emitter.threshold != 0.0f)
-            ss << "  threshold " << emitter.threshold << "\n";
-        if (emitter.fps != 0.0f)
-            ss << "  fps " << emitter.fps << "\n";
-        if (emitter.frameStart != 0.0f)
-            ss << "  frameStart " << emitter.frameStart << "\n";
-        if (emitter.frameEnd != 0.0f)
-            ss << "  frameEnd " << emitter.frameEnd << "\n";
-        if (emitter.bounce_co != 0.0f)
-            ss << "  bounce_co " << emitter.bounce_co << "\n";
-        if (emitter.combinetime != 0.0f)
-            ss << "  combinetime " << emitter.combinetime << "\n";
-        if (emitter.blurlength != 0.0f)
-            ss << "  blurlength " << emitter.blurlength << "\n";
-
-        // Lightning properties
-        if (emitter.lightningDelay != 0.0f)
-            ss << "  lightningDelay " << emitter.lightningDelay << "\n";
-        if (emitter.lightningRadius != 0.0f)
-            ss << "  lightningRadius " << emitter.lightningRadius << "\n";
-        if (emitter.lightningScale != 0.0f)
-            ss << "  lightningScale " << emitter.lightningScale << "\n";
-        if (emitter.lightningSubDiv != 0.0f)
-            ss << "  lightningSubDiv " << emitter.lightningSubDiv << "\n";
-        if (emitter.lightningZigZag != 0.0f)
-            ss << "  lightningZigZag " << emitter.lightningZigZag << "\n";
-
-
-        ss << "endnode\n";
-    }
-
-    ss << "endmodelgeom " << modelName << "\n";
+    for (size_t i = 0; i < emitters.size(); ++i)
+    {
+        mdlText += getEmitterText(i);
+    }
+
+    mdlText += "endmodelgeom " + modelName + "\n";
 
-    return ss.str();
+    if (!nodes.empty() || !animations.empty())
+    {
+        for (size_t i = 0; i < animations.size(); ++i)
+        {
+            mdlText += "newanim " + animations[i].name + " " + modelName + "\n";
+            if (!rootNodeName.empty() && rootNodeName != modelName)
+                mdlText += renameAnimationNode(getAnimationBody(i), rootNodeName, modelName);
+            else
+                mdlText += getAnimationBody(i);
+            mdlText += "doneanim " + animations[i].name + " " + modelName + "\n";
+            complete = complete && animationBodyLoaded[i];
+        }
+        mdlText += "donemodel " + modelName + "\n";
+    }
+
+    // Bodies lost to a changed source will not load on a retry either
+    mdlTextRevision = complete || sourceChanged ? revision : UINT64_MAX;
+    return mdlText;
 }
 
-void EmitterEditor::loadFromMDL(const std::string& filename)
+std::string EmitterEditor::exportNodeName(const std::string& name) const
 {
-    std::ifstream file(filename);
-    if (!file.is_open())
+    return !rootNodeName.empty() && name == rootNodeName ? modelName : name;
+}
+
+std::string EmitterEditor::resolveParent(const std::string& parent) const
+{
+    // Parents that no longer exist, including a root from before the model was renamed, fall back to the root
+    if (parent != rootNodeName && findEmitter(parent) >= 0)
+    {
+        return parent;
+    }
+    if (parent != rootNodeName &&
+        std::any_of(nodes.begin(), nodes.end(), [&](const ModelNode& node) { return node.name == parent; }))
+    {
+        return parent;
+    }
+    return modelName;
+}
+
+bool EmitterEditor::loadFromMDL(const std::string& filename, const MDLLoadObserver* observer)
+{
+    MappedFile mapped;
+    if (!mapped.open(filename))
     {
         std::cerr << "Failed to open file: " << filename << std::endl;
-        return;
+        return false;
+    }
+
+    if (!loadFromMemory(filename, mapped.data(), mapped.size(), observer))
+        return false;
+    sourceFile = filename;
+    sourceSize = mapped.size();
+    std::error_code ec;
+    sourceTime = std::filesystem::last_write_time(filename, ec).time_since_epoch().count();
+    return true;
+}
+
+bool EmitterEditor::loadFromMDL(const std::string& name, std::shared_ptr<const MappedFile> archive,
+                                const unsigned char* data, size_t size, const MDLLoadObserver* observer)
+{
+    if (!loadFromMemory(name, data, size, observer))
+        return false;
+    sourceArchive = std::move(archive);
+    sourceData = data;
+    return true;
+}
+
+bool EmitterEditor::loadFromMemory(const std::string& filename, const unsigned char* data, size_t size,
+                                   const MDLLoadObserver* observer)
+{
+    // Compiled models are parsed straight from the mapped data
+    if (isBinaryMDL(data, size))
+    {
+        return loadFromBinaryMDL(filename, data, size, observer);
     }
 
     // Update texture directory to the directory containing the MDL file
     textureDirectory = std::filesystem::path(filename).parent_path().string();
+    saveFormat = MDLFormat::Ascii;
 
     emitters.clear();
+    nameIndex.clear();
+    clearModelData();
 
-    std::string line;
-    EmitterNode* currentEmitter = nullptr;
+    LineReader reader(std::string_view(reinterpret_cast<const char*>(data), size));
+    std::string_view lineView;
+    // Index rather than pointer, later push_backs may reallocate the vector
+    int currentIndex = -1;
+    ModelNode* currentNode = nullptr;
+    uint64_t lastReported = 0;
 
-    while (std::getline(file, line))
+    while (reader.next(lineView))
     {
-        std::stringstream ss(line);
-        std::string token;
-        ss >> token;
-
-        if (token == "node")
+        if (observer)
         {
-            std::string nodeType;
-            ss >> nodeType;
-            if (nodeType == "emitter")
+            if (observer->cancel && observer->cancel->load(std::memory_order_relaxed))
             {
-                std::string name;
-                ss >> name;
+                return false;
+            }
+            if (observer->progress && reader.position() - lastReported >= 64 * 1024)
+            {
+                observer->progress(reader.position());
+                lastReported = reader.position();
+            }
+        }
 
-                // Check if this emitter already exists (animation keyframes)
-                auto existingIt = std::find_if(emitters.begin(), emitters.end(),
-                                               [&name](const EmitterNode& emitter) { return emitter.name == name; });
+        std::string_view token = firstToken(lineView);
 
-                if (existingIt != emitters.end())
+        // Raw node text is captured without tokenizing, mesh nodes can hold thousands of vertex lines
+        if (currentNode)
+        {
+            if (token == "endnode")
+            {
+                currentNode = nullptr;
+            }
+            else if (token == "parent" || token == "position" || token == "orientation")
+            {
+                std::istringstream ss{std::string(lineView)};
+                std::string skip;
+                ss >> skip;
+                if (token == "parent")
+                {
+                    ss >> currentNode->parent;
+                    continue; // Written from the parsed value
+                }
+                if (token == "position")
                 {
-                    currentEmitter = &(*existingIt); // Parse animation data for existing emitter
+                    ss >> currentNode->position.x >> currentNode->position.y >> currentNode->position.z;
                 }
                 else
+                {
+                    float x = 0.0f, y = 0.0f, z = 1.0f, angle = 0.0f;
+                    ss >> x >> y >> z >> angle;
+                    if (angle != 0.0f && glm::length(glm::vec3(x, y, z)) > 0.0f)
+                    {
+                        currentNode->orientation = glm::angleAxis(angle, glm::normalize(glm::vec3(x, y, z)));
+                    }
+                }
+                currentNode->body.append(lineView);
+                currentNode->body += '\n';
+            }
+            else
+            {
+                currentNode->body.append(lineView);
+                currentNode->body += '\n';
+            }
+            continue;
+        }
+
+        if (token == "newanim")
+        {
+            // Only locate the section here, it is parsed when the user selects it
+            std::istringstream ss{std::string(lineView)};
+            std::string skip;
+            ModelAnimation animation;
+            ss >> skip >> animation.name;
+            animation.bodyOffset = reader.position();
+            size_t doneAnim = reader.findLineStartingWith("doneanim");
+            animation.bodySize = doneAnim - animation.bodyOffset;
+            animations.push_back(std::move(animation));
+
+            reader.seek(doneAnim);
+            reader.next(lineView); // Skip the doneanim line itself
+            continue;
+        }
+
+        std::istringstream ss{std::string(lineView)};
+        std::string skip;
+        ss >> skip;
+
+        if (token == "newmodel")
+        {
+            ss >> modelName;
+        }
+        else if (token == "setsupermodel")
+        {
+            ss >> skip >> supermodel;
+        }
+        else if (token == "classification")
+        {
+            ss >> classification;
+        }
+        else if (token == "node")
+        {
+            std::string nodeType;
+            std::string name;
+            ss >> nodeType >> name;
+            if (nodeType == "emitter")
+            {
+                // A repeated name within the geometry block refers to the same emitter
+                currentIndex = findEmitter(name);
+                if (currentIndex < 0)
                 {
                     // Create a fresh emitter with defaults, then we'll parse its properties
                     EmitterNode emitter = createDefaultEmitter();
                     emitter.name = name;
+                    currentIndex = static_cast<int>(emitters.size());
+                    nameIndex.emplace(emitter.name, emitters.size());
                     emitters.push_back(emitter);
-                    currentEmitter = &emitters.back();
                 }
             }
+            else
+            {
+                ModelNode node;
+                node.type = nodeType;
+                node.name = name;
+                nodes.push_back(std::move(node));
+                currentNode = &nodes.back();
+            }
         }
-        else if (currentEmitter && token == "endnode")
+        else if (currentIndex >= 0 && token == "endnode")
         {
-            currentEmitter = nullptr;
+            currentIndex = -1;
         }
-        else if (currentEmitter)
+        else if (currentIndex >= 0)
         {
+            EmitterNode* currentEmitter = &emitters[currentIndex];
+
             // Parse emitter properties
             if (token == "parent")
             {
                 ss >> currentEmitter->parent;
             }
-            else if (token == "p2p")
-            {
-                int val;
-                ss >> val;
-                currentEmitter->p2p = (val != 0);
-            }
-            else if (token == "p2p_sel")
+            else if (token == "positionkey" || token == "orientationkey")
             {
-                ss >> currentEmitter->p2p_sel;
-            }
-            else if (token == "affectedByWind")
-            {
-                int val;
-                ss >> val;
-                currentEmitter->affectedByWind = (val != 0);
-            }
-            else if (token == "m_isTinted")
-            {
-                int val;
-                ss >> val;
-                currentEmitter->m_isTinted = (val != 0);
-            }
-            else if (token == "bounce")
-            {
-                int val;
-                ss >> val;
-                currentEmitter->bounce = (val != 0);
-            }
-            else if (token == "random")
-            {
-                int val;
-                ss >> val;
-                currentEmitter->random = (val != 0);
-            }
-            else if (token == "inherit")
-            {
-                int val;
-                ss >> val;
-                currentEmitter->inherit = (val != 0);
-            }
-            else if (token == "inheritvel")
-            {
-                int val;
-                ss >> val;
-                currentEmitter->inheritvel = (val != 0);
-            }
-            else if (token == "inherit_local")
-            {
-                int val;
-                ss >> val;
-                currentEmitter->inherit_local = (val != 0);
-            }
-            else if (token == "splat")
-            {
-                int val;
-                ss >> val;
-                currentEmitter->splat = (val != 0);
-            }
-            else if (token == "inherit_part")
-            {
-                int val;
-                ss >> val;
-                currentEmitter->inherit_part = (val != 0);
-            }
-            else if (token == "renderorder")
-            {
-                ss >> currentEmitter->renderorder;
-            }
-            else if (token == "spawntype")
-            {
-                int val;
-                ss >> val;
-                currentEmitter->spawntype = static_cast<SpawnType>(val);
-            }
-            else if (token == "update")
-            {
-                std::string updateStr;
-                ss >> updateStr;
-                if (updateStr == "Fountain")
-                    currentEmitter->update = UpdateType::Fountain;
-                else if (updateStr == "Single")
-                    currentEmitter->update = UpdateType::Single;
-                else if (updateStr == "Explosion")
-                    currentEmitter->update = UpdateType::Explosion;
-                else if (updateStr == "Lightning")
-                    currentEmitter->update = UpdateType::Lightning;
-            }
-            else if (token == "render")
-            {
-                std::string renderStr;
-                ss >> renderStr;
-                if (renderStr == "Normal")
-                    currentEmitter->render = RenderType::Normal;
-                else if (renderStr == "Linked")
-                    currentEmitter->render = RenderType::Linked;
-                else if (renderStr == "Billboard_to_Local_Z")
-                    currentEmitter->render = RenderType::Billboard_to_Local_Z;
-                else if (renderStr == "Billboard_to_World_Z")
-                    currentEmitter->render = RenderType::Billboard_to_World_Z;
-                else if (renderStr == "Aligned_to_World_Z")
-                    currentEmitter->render = RenderType::Aligned_to_World_Z;
-                else if (renderStr == "Aligned_to_Particle_Direction")
-                    currentEmitter->render = RenderType::Aligned_to_Particle_Direction;
-                else if (renderStr == "Motion_Blur")
-                    currentEmitter->render = RenderType::Motion_Blur;
-            }
-            else if (token == "blend")
-            {
-                std::string blendStr;
-                ss >> blendStr;
-                if (blendStr == "Normal")
-                    currentEmitter->blend = BlendType::Normal;
-                else if (blendStr == "Punch-Through")
-                    currentEmitter->blend = BlendType::Punch_Through;
-                else if (blendStr == "Lighten")
-                    currentEmitter->blend = BlendType::Lighten;
-            }
-            else if (token == "texture")
-            {
-                ss >> currentEmitter->texture;
-            }
-            else if (token == "xgrid")
-            {
-                ss >> currentEmitter->xgrid;
-            }
-            else if (token == "ygrid")
-            {
-                ss >> currentEmitter->ygrid;
-            }
-            else if (token == "loop")
-            {
-                int val;
-                ss >> val;
-                currentEmitter->loop = (val != 0);
-            }
-            else if (token == "deadspace")
-            {
-                ss >> currentEmitter->deadspace;
-            }
-            else if (token == "twosidedtex")
-            {
-                int val;
-                ss >> val;
-                currentEmitter->twosidedtex = (val != 0);
-            }
-            else if (token == "blastRadius")
-            {
-                ss >> currentEmitter->blastRadius;
-            }
-            else if (token == "blastLength")
-            {
-                ss >> currentEmitter->blastLength;
-            }
-            else if (token == "position")
-            {
-                glm::vec3 mdlPos;
-                ss >> mdlPos.x >> mdlPos.y >> mdlPos.z;
-                currentEmitter->position = mdlPos;
-            }
-            else if (token == "orientation")
-            {
-                float x, y, z, angle;
-                ss >> x >> y >> z >> angle;
-
-                if (angle < 0.001f)
-                {
-                    // No rotation
-                    currentEmitter->rotationAngles = glm::vec3(0.0f);
-                }
+                int numKeys = 0;
+                ss >> numKeys;
+                if (token == "positionkey")
+                    readKeyframes(reader, numKeys, currentEmitter->positionKeys);
                 else
-                {
-                    // Convert axis-angle to quaternion, then to euler angles for storage
-                    glm::vec3 axis(x, y, z);
-                    glm::quat quat = glm::angleAxis(angle, glm::normalize(axis));
-                    currentEmitter->rotationAngles = glm::degrees(glm::eulerAngles(quat));
-                }
-            }
-            else if (token == "xsize")
-            {
-                float mdlValue;
-                ss >> mdlValue;
-                currentEmitter->xsize = mdlValue / 100.0f;
-            }
-            else if (token == "ysize")
-            {
-                float mdlValue;
-                ss >> mdlValue;
-                currentEmitter->ysize = mdlValue / 100.0f;
-            }
-            else if (token == "colorStart")
-            {
-                ss >> currentEmitter->colorStart.r >> currentEmitter->colorStart.g >> currentEmitter->colorStart.b;
-            }
-            else if (token == "colorEnd")
-            {
-                ss >> currentEmitter->colorEnd.r >> currentEmitter->colorEnd.g >> currentEmitter->colorEnd.b;
-            }
-            else if (token == "alphaStart")
-            {
-                ss >> currentEmitter->alphaStart;
-            }
-            else if (token == "alphaEnd")
-            {
-                ss >> currentEmitter->alphaEnd;
+                    readKeyframes(reader, numKeys, currentEmitter->orientationKeys);
             }
-            else if (token == "sizeStart")
+            else if (const EmitterField* field = findEmitterField(std::string(token)))
             {
-                ss >> currentEmitter->sizeStart;
-            }
-            else if (token == "sizeEnd")
-            {
-                ss >> currentEmitter->sizeEnd;
-            }
-            else if (token == "sizeStart_y")
-            {
-                ss >> currentEmitter->sizeStart_y;
-            }
-            else if (token == "sizeEnd_y")
-            {
-                ss >> currentEmitter->sizeEnd_y;
-            }
-            else if (token == "birthrate")
-            {
-                ss >> currentEmitter->birthrate;
-            }
-            else if (token == "lifeExp")
-            {
-                ss >> currentEmitter->lifeExp;
-            }
-            else if (token == "mass")
-            {
-                ss >> currentEmitter->mass;
-            }
-            else if (token == "spread")
-            {
-                ss >> currentEmitter->spread;
-            }
-            else if (token == "particleRot")
-            {
-                ss >> currentEmitter->particleRot;
-            }
-            else if (token == "velocity")
-            {
-                ss >> currentEmitter->velocity;
-            }
-            else if (token == "grav")
-            {
-                ss >> currentEmitter->grav;
-            }
-            else if (token == "drag")
-            {
-                ss >> currentEmitter->drag;
-            }
-            else if (token == "threshold")
-            {
-                ss >> currentEmitter->threshold;
-            }
-            else if (token == "fps")
-            {
-                ss >> currentEmitter->fps;
-            }
-            else if (token == "frameStart")
-            {
-                ss >> currentEmitter->frameStart;
-            }
-            else if (token == "frameEnd")
-            {
-                ss >> currentEmitter->frameEnd;
-            }
-            else if (token == "bounce_co")
-            {
-                ss >> currentEmitter->bounce_co;
-            }
-            else if (token == "combinetime")
-            {
-                ss >> currentEmitter->combinetime;
-            }
-            else if (token == "blurlength")
-            {
-                ss >> currentEmitter->blurlength;
-            }
-            else if (token == "lightningDelay")
-            {
-                ss >> currentEmitter->lightningDelay;
-            }
-            else if (token == "lightningRadius")
-            {
-                ss >> currentEmitter->lightningRadius;
-            }
-            else if (token == "lightningScale")
-            {
-                ss >> currentEmitter->lightningScale;
-            }
-            else if (token == "lightningSubDiv")
-            {
-                ss >> currentEmitter->lightningSubDiv;
-            }
-            else if (token == "lightningZigZag")
-            {
-                ss >> currentEmitter->lightningZigZag;
-            }
-            else if (token == "positionkey")
-            {
-                // Parse position animation keyframes
-                int numKeys;
-                ss >> numKeys;
-                currentEmitter->positionKeys.keyframes.clear();
-
-                for (int i = 0; i < numKeys; ++i)
+                if (parseEmitterField(*field, *currentEmitter, ss) && observer && observer->textureFound &&
+                    std::string_view(field->name) == "texture")
                 {
-                    if (std::getline(file, line))
-                    {
-                        std::stringstream keyss(line);
-                        float time, x, y, z;
-                        keyss >> time >> x >> y >> z;
-                        glm::vec3 mdlPos(x, y, z);
-                        currentEmitter->positionKeys.keyframes.emplace_back(time, mdlPos);
-                    }
+                    observer->textureFound(currentEmitter->texture);
                 }
             }
-            else if (token == "orientationkey")
-            {
-                // Parse orientation animation keyframes
-                int numKeys;
-                ss >> numKeys;
-                currentEmitter->orientationKeys.keyframes.clear();
+        }
+    }
 
-                for (int i = 0; i < numKeys; ++i)
-                {
-                    if (std::getline(file, line))
-                    {
-                        std::stringstream keyss(line);
-                        float time, x, y, z, w;
-                        keyss >> time >> x >> y >> z >> w;
-                        currentEmitter->orientationKeys.keyframes.emplace_back(time, glm::vec3(x, y, z));
-                    }
-                }
+    // Root dummy: the parentless node named after the model
+    for (const auto& node : nodes)
+    {
+        if (node.parent == "NULL")
+        {
+            rootNodeName = node.name;
+            break;
+        }
+    }
+
+    animationBodies.assign(animations.size(), std::string());
+    animationBodyLoaded.assign(animations.size(), false);
+
+    for (auto& emitter : emitters)
+    {
+        bakeTracks(emitter);
+    }
+    resetGenerations();
+    if (observer && observer->progress)
+    {
+        observer->progress(size);
+    }
+    return true;
+}
+
+void EmitterEditor::clearModelData()
+{
+    nodes.clear();
+    modelNodesRevision = bumpRevision();
+    animations.clear();
+    animationBodies.clear();
+    animationBodyLoaded.clear();
+    sourceFile.clear();
+    sourceSize = 0;
+    sourceTime = 0;
+    sourceChanged = false;
+    detached = false;
+    sourceArchive.reset();
+    sourceData = nullptr;
+    incompleteSource = false;
+    rootNodeName.clear();
+    supermodel = "NULL";
+    classification = "effect";
+    selectedAnimation = -1;
+}
+
+const std::string& EmitterEditor::getAnimationBody(size_t index) const
+{
+    readAnimationBody(index);
+    return animationBodies[index];
+}
+
+bool EmitterEditor::readAnimationBody(size_t index) const
+{
+    if (animationBodyLoaded[index])
+        return true;
+    if (sourceChanged)
+        return false; // Already reported, the file will not change back
+
+    const ModelAnimation& animation = animations[index];
+    std::string& body = animationBodies[index];
+    if (sourceArchive)
+    {
+        // Still mapped, the offsets were checked while parsing
+        body.assign(reinterpret_cast<const char*>(sourceData) + animation.bodyOffset, animation.bodySize);
+    }
+    else
+    {
+        // The offsets only hold for the file as it was parsed
+        std::error_code sizeError, timeError;
+        bool unchanged = std::filesystem::file_size(sourceFile, sizeError) == sourceSize &&
+            std::filesystem::last_write_time(sourceFile, timeError).time_since_epoch().count() == sourceTime &&
+            !sizeError && !timeError;
+
+        std::ifstream file(sourceFile, std::ios::binary);
+        body.resize(animation.bodySize);
+        file.seekg(static_cast<std::streamoff>(animation.bodyOffset));
+        if (!unchanged || !file.read(body.data(), static_cast<std::streamsize>(body.size())))
+        {
+            sourceChanged = !unchanged;
+            std::cerr << "Failed to read animation " << animation.name << " from " << sourceFile
+                      << (unchanged ? "" : ", it changed since it was loaded") << std::endl;
+            body.clear();
+            return false;
+        }
+    }
+    animationBodyLoaded[index] = true;
+    return true;
+}
+
+bool EmitterEditor::readAnimationBodies() const
+{
+    bool complete = true;
+    for (size_t i = 0; i < animations.size(); ++i)
+    {
+        complete = readAnimationBody(i) && complete;
+    }
+    return complete;
+}
+
+void EmitterEditor::parseAnimationBody(size_t index)
+{
+    ModelAnimation& animation = animations[index];
+    LineReader reader(getAnimationBody(index));
+    std::string_view lineView;
+    int currentIndex = -1;
+
+    while (reader.next(lineView))
+    {
+        std::string_view token = firstToken(lineView);
+        std::istringstream ss{std::string(lineView)};
+        std::string skip;
+        ss >> skip;
+
+        if (token == "length")
+        {
+            ss >> animation.length;
+        }
+        else if (token == "node")
+        {
+            std::string nodeType;
+            std::string name;
+            ss >> nodeType >> name;
+            currentIndex = nodeType == "emitter" ? findEmitter(name) : -1;
+        }
+        else if (token == "endnode")
+        {
+            currentIndex = -1;
+        }
+        else if (currentIndex >= 0 && (token == "positionkey" || token == "orientationkey"))
+        {
+            EmitterNode& emitter = emitters[currentIndex];
+            int numKeys = 0;
+            ss >> numKeys;
+            if (token == "positionkey")
+                readKeyframes(reader, numKeys, emitter.positionKeys);
+            else
+                readKeyframes(reader, numKeys, emitter.orientationKeys);
+        }
+    }
+
+    for (auto& emitter : emitters)
+    {
+        bakeTracks(emitter);
+    }
+    animation.parsed = true;
+}
+
+void EmitterEditor::setBakeLongTracks(bool bake)
+{
+    bakeLongTracks = bake;
+    for (auto& emitter : emitters)
+    {
+        bakeTracks(emitter);
+    }
+}
+
+void EmitterEditor::bakeTracks(EmitterNode& emitter) const
+{
+    bakeTrack(emitter.positionKeys, bakeLongTracks);
+    bakeTrack(emitter.orientationKeys, bakeLongTracks);
+}
+
+void EmitterEditor::selectAnimation(int index)
+{
+    if (index >= static_cast<int>(animations.size()))
+    {
+        return;
+    }
+
+    for (auto& emitter : emitters)
+    {
+        emitter.positionKeys.clear();
+        emitter.orientationKeys.clear();
+    }
+
+    selectedAnimation = index;
+    if (index >= 0)
+    {
+        // Keys are not kept per animation, re-reading the cached section text is cheap
+        parseAnimationBody(static_cast<size_t>(index));
+    }
+}
+
+bool EmitterEditor::loadFromBinaryMDL(const std::string& filename, const unsigned char* data, size_t size,
+                                      const MDLLoadObserver* observer)
+{
+    BinaryModel model;
+    if (!readBinaryMDL(data, size, model))
+    {
+        std::cerr << "Invalid binary MDL: " << filename << std::endl;
+        return false;
+    }
+
+    textureDirectory = std::filesystem::path(filename).parent_path().string();
+    clearModelData();
+    emitters = std::move(model.emitters);
+    nodes = std::move(model.dummies);
+    if (!model.name.empty())
+    {
+        modelName = model.name;
+    }
+    if (!nodes.empty())
+    {
+        rootNodeName = nodes.front().name;
+    }
+
+    // Meshes and animations are not read, writing the model back would drop them
+    incompleteSource = !model.complete;
+    saveFormat = incompleteSource ? MDLFormat::Ascii : MDLFormat::Binary;
+    if (incompleteSource)
+    {
+        std::cerr << "Only the dummies and emitters of " << filename << " are loaded, save it to a new file"
+                  << std::endl;
+    }
+    for (auto& emitter : emitters)
+    {
+        bakeTracks(emitter);
+    }
+    rebuildNameIndex();
+    resetGenerations();
+
+    if (observer)
+    {
+        if (observer->textureFound)
+        {
+            for (const auto& emitter : emitters)
+            {
+                if (!emitter.texture.empty())
+                    observer->textureFound(emitter.texture);
             }
         }
+        if (observer->progress)
+        {
+            observer->progress(size);
+        }
     }
+    return true;
 }
 
-void EmitterEditor::saveToMDL(const std::string& filename)
+bool EmitterEditor::canSaveBinary() const
 {
+    // The binary writer only knows dummies and emitters
+    return animations.empty() &&
+        std::all_of(nodes.begin(), nodes.end(), [](const ModelNode& node) { return node.type == "dummy"; });
+}
+
+bool EmitterEditor::saveToMDL(const std::string& filename)
+{
+    std::error_code ec;
+    if (incompleteSource && (filename == sourceFile || std::filesystem::equivalent(filename, sourceFile, ec)))
+    {
+        std::cerr << "Not overwriting " << filename << ", parts of it were not loaded" << std::endl;
+        return false;
+    }
+
+    if (saveFormat == MDLFormat::Binary)
+    {
+        if (!canSaveBinary())
+        {
+            std::cerr << "Meshes and animations can only be saved as ASCII: " << filename << std::endl;
+            return false;
+        }
+
+        std::vector<unsigned char> data = writeBinaryMDL(modelName, nodes, emitters);
+        if (data.empty())
+        {
+            std::cerr << "Too many animation keys for a binary model: " << filename << std::endl;
+            return false;
+        }
+
+        std::ofstream file(filename, std::ios::binary);
+        if (!file.is_open())
+        {
+            std::cerr << "Failed to create file: " << filename << std::endl;
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        return static_cast<bool>(file);
+    }
+
+    // Read before opening, animation text may still have to come from the file being overwritten
+    if (!readAnimationBodies())
+    {
+        std::cerr << "Not saving " << filename << ", its animations could not be read" << std::endl;
+        return false;
+    }
+    const std::string& text = generateMDLText();
+
     std::ofstream file(filename);
     if (!file.is_open())
     {
         std::cerr << "Failed to create file: " << filename << std::endl;
-        return;
+        return false;
     }
 
-    file << generateMDLText();
+    file << text;
     file.close();
+    return static_cast<bool>(file);
 }
@@ -0,0 +1,383 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "emitter_fields.hpp"
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <type_traits>
+#include <unordered_map>
+
+namespace
+{
+    template <typename Enum>
+    constexpr auto enumNames()
+    {
+        if constexpr (std::is_same_v<Enum, UpdateType>)
+            return updateTypeNames;
+        else if constexpr (std::is_same_v<Enum, RenderType>)
+            return renderTypeNames;
+        else
+            return blendTypeNames;
+    }
+
+    template <typename T>
+    constexpr bool isNamedEnum =
+        std::is_same_v<T, UpdateType> || std::is_same_v<T, RenderType> || std::is_same_v<T, BlendType>;
+
+    // FNV-1a, fed field by field
+    void hashBytes(uint64_t& hash, const void* data, size_t size)
+    {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    }
+
+    void hashFloat(uint64_t& hash, float value)
+    {
+        // +0 and -0 compare equal, so they must hash equal too
+        if (value == 0.0f)
+            value = 0.0f;
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        hashBytes(hash, &bits, sizeof(bits));
+    }
+
+    // Shortest text that parses back to the same float, without exponent notation
+    void appendFloat(std::string& out, float value)
+    {
+        char buffer[64];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed);
+        out.append(buffer, result.ptr);
+    }
+
+    void appendInt(std::string& out, int value)
+    {
+        char buffer[16];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, result.ptr);
+    }
+
+    void appendVec3(std::string& out, const glm::vec3& value)
+    {
+        appendFloat(out, value.x);
+        out += ' ';
+        appendFloat(out, value.y);
+        out += ' ';
+        appendFloat(out, value.z);
+    }
+
+    void writeAxisAngle(const glm::vec3& rotationAngles, std::string& out)
+    {
+        // Convert stored angles to quaternion, then to axis-angle for MDL
+        glm::quat quat = glm::quat(glm::radians(rotationAngles));
+        float angle = glm::angle(quat);
+
+        if (angle < 0.001f)
+        {
+            // No rotation
+            out += "  orientation 0.0 0.0 1.0 0.0\n";
+        }
+        else
+        {
+            // Get normalized axis from quaternion, angle already in radians
+            out += "  orientation ";
+            appendVec3(out, glm::axis(quat));
+            out += ' ';
+            appendFloat(out, angle);
+            out += '\n';
+        }
+    }
+} // namespace
+
+const EmitterField* findEmitterField(std::string_view name)
+{
+    static const std::unordered_map<std::string_view, const EmitterField*> index = []
+    {
+        std::unordered_map<std::string_view, const EmitterField*> map;
+        for (const auto& field : emitterFields)
+        {
+            map.emplace(field.name, &field);
+        }
+        return map;
+    }();
+
+    auto it = index.find(name);
+    return it != index.end() ? it->second : nullptr;
+}
+
+void applyEmitterFieldDefaults(EmitterNode& emitter)
+{
+    for (const auto& field : emitterFields)
+    {
+        const auto& def = field.defaultValue;
+        std::visit(
+            [&](auto member)
+            {
+                auto& value = emitter.*member;
+                using T = std::remove_reference_t<decltype(value)>;
+                if constexpr (std::is_same_v<T, glm::vec3>)
+                    value = glm::vec3(def[0], def[1], def[2]);
+                else if constexpr (std::is_same_v<T, std::string>)
+                    value.clear();
+                else if constexpr (std::is_same_v<T, bool>)
+                    value = def[0] != 0.0f;
+                else
+                    value = static_cast<T>(def[0]);
+            },
+            field.member);
+    }
+}
+
+bool parseEmitterField(const EmitterField& field, EmitterNode& emitter, std::istream& in)
+{
+    return std::visit(
+        [&](auto member) -> bool
+        {
+            auto& value = emitter.*member;
+            using T = std::remove_reference_t<decltype(value)>;
+
+            if constexpr (std::is_same_v<T, bool>)
+            {
+                int val;
+                if (!(in >> val))
+                    return false;
+                value = (val != 0);
+            }
+            else if constexpr (std::is_same_v<T, int>)
+            {
+                if (!(in >> value))
+                    return false;
+            }
+            else if constexpr (std::is_same_v<T, float>)
+            {
+                float mdlValue;
+                if (!(in >> mdlValue))
+                    return false;
+                value = mdlValue / field.scale;
+            }
+            else if constexpr (std::is_same_v<T, std::string>)
+            {
+                if (!(in >> value))
+                    return false;
+            }
+            else if constexpr (std::is_same_v<T, SpawnType>)
+            {
+                int val;
+                if (!(in >> val))
+                    return false;
+                value = static_cast<SpawnType>(val);
+            }
+            else if constexpr (isNamedEnum<T>)
+            {
+                std::string name;
+                if (!(in >> name))
+                    return false;
+                constexpr auto names = enumNames<T>();
+                for (size_t i = 0; i < names.size(); ++i)
+                {
+                    if (names[i] == name)
+                    {
+                        value = static_cast<T>(i);
+                        return true;
+                    }
+                }
+                return false; // Unknown names keep the current value
+            }
+            else if constexpr (std::is_same_v<T, glm::vec3>)
+            {
+                if (field.type == FieldType::AxisAngle)
+                {
+                    float x, y, z, angle;
+                    if (!(in >> x >> y >> z >> angle))
+                        return false;
+
+                    if (angle < 0.001f)
+                    {
+                        // No rotation
+                        value = glm::vec3(0.0f);
+                    }
+                    else
+                    {
+                        // Convert axis-angle to quaternion, then to euler angles for storage
+                        glm::quat quat = glm::angleAxis(angle, glm::normalize(glm::vec3(x, y, z)));
+                        value = glm::degrees(glm::eulerAngles(quat));
+                    }
+                }
+                else
+                {
+                    glm::vec3 parsed;
+                    if (!(in >> parsed.x >> parsed.y >> parsed.z))
+                        return false;
+                    value = parsed;
+                }
+            }
+            return true;
+        },
+        field.member);
+}
+
+bool isEmitterFieldOmitted(const EmitterField& field, const EmitterNode& emitter)
+{
+    switch (field.omit)
+    {
+    case OmitRule::IfZero:
+        return std::visit(
+            [&](auto member)
+            {
+                const auto& value = emitter.*member;
+                using T = std::remove_cvref_t<decltype(value)>;
+                if constexpr (std::is_same_v<T, float> || std::is_same_v<T, int>)
+                    return value == 0;
+                else
+                    return false;
+            },
+            field.member);
+    case OmitRule::IfEmpty:
+        return std::visit(
+            [&](auto member)
+            {
+                const auto& value = emitter.*member;
+                if constexpr (std::is_same_v<std::remove_cvref_t<decltype(value)>, std::string>)
+                    return value.empty();
+                else
+                    return false;
+            },
+            field.member);
+    case OmitRule::IfNoGeometry:
+        return !(emitter.xsize > 0 || emitter.ysize > 0);
+    case OmitRule::IfDefault:
+        return std::visit(
+            [&](auto member)
+            {
+                const auto& value = emitter.*member;
+                using T = std::remove_cvref_t<decltype(value)>;
+                const auto& def = field.defaultValue;
+                if constexpr (std::is_same_v<T, float>)
+                    return value == def[0];
+                else if constexpr (std::is_same_v<T, glm::vec3>)
+                    return value == glm::vec3(def[0], def[1], def[2]);
+                else
+                    return false;
+            },
+            field.member);
+    case OmitRule::Never:
+    default:
+        return false;
+    }
+}
+
+void writeEmitterField(const EmitterField& field, const EmitterNode& emitter, std::string& out)
+{
+    if (isEmitterFieldOmitted(field, emitter))
+        return;
+
+    std::visit(
+        [&](auto member)
+        {
+            const auto& value = emitter.*member;
+            using T = std::remove_cvref_t<decltype(value)>;
+
+            if constexpr (std::is_same_v<T, glm::vec3>)
+            {
+                if (field.type == FieldType::AxisAngle)
+                {
+                    writeAxisAngle(value, out);
+                    return;
+                }
+            }
+
+            out += "  ";
+            out += field.name;
+            out += ' ';
+
+            if constexpr (std::is_same_v<T, glm::vec3>)
+                appendVec3(out, value);
+            else if constexpr (std::is_same_v<T, bool>)
+                out += value ? '1' : '0';
+            else if constexpr (std::is_same_v<T, float>)
+                appendFloat(out, value * field.scale);
+            else if constexpr (std::is_same_v<T, int>)
+                appendInt(out, value);
+            else if constexpr (isNamedEnum<T>)
+                out += enumNames<T>()[static_cast<size_t>(value)];
+            else if constexpr (std::is_same_v<T, SpawnType>)
+                appendInt(out, static_cast<int>(value));
+            else
+                out += value;
+
+            out += '\n';
+        },
+        field.member);
+}
+
+bool emitterFieldEquals(const EmitterField& field, const EmitterNode& a, const EmitterNode& b)
+{
+    return std::visit([&](auto member) { return a.*member == b.*member; }, field.member);
+}
+
+std::vector<const EmitterField*> diffEmitterFields(const EmitterNode& a, const EmitterNode& b)
+{
+    std::vector<const EmitterField*> changed;
+    for (const auto& field : emitterFields)
+    {
+        if (!emitterFieldEquals(field, a, b))
+        {
+            changed.push_back(&field);
+        }
+    }
+    return changed;
+}
+
+size_t hashEmitterFields(const EmitterNode& emitter)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (const auto& field : emitterFields)
+    {
+        std::visit(
+            [&](auto member)
+            {
+                const auto& value = emitter.*member;
+                using T = std::remove_cvref_t<decltype(value)>;
+                if constexpr (std::is_same_v<T, float>)
+                    hashFloat(hash, value);
+                else if constexpr (std::is_same_v<T, glm::vec3>)
+                {
+                    hashFloat(hash, value.x);
+                    hashFloat(hash, value.y);
+                    hashFloat(hash, value.z);
+                }
+                else if constexpr (std::is_same_v<T, std::string>)
+                {
+                    hashBytes(hash, value.data(), value.size());
+                    hashBytes(hash, "", 1); // Separator so "ab"+"c" != "a"+"bc"
+                }
+                else
+                {
+                    int32_t intValue = static_cast<int32_t>(value);
+                    hashBytes(hash, &intValue, sizeof(intValue));
+                }
+            },
+            field.member);
+    }
+    return static_cast<size_t>(hash);
+}
@@ -29,6 +29,7 @@ std::string FileDialog::lastSavedFilename = "";
 std::string FileDialog::searchFilter = "";
 std::vector<std::filesystem::path> FileDialog::cachedDirectoryContents;
 bool FileDialog::filesLoaded = false;
+TextureIndex FileDialog::browsedTextures;
 
 // Initialize default path based on platform
 static std::string getDefaultPath()
@@ -52,6 +53,12 @@ static std::string getDefaultPath()
 #endif
 }
 
+// Compares paths that may differ only in a trailing separator or dot segments
+static bool isSameDirectory(const std::string& a, const std::string& b)
+{
+    return (std::filesystem::path(a) / "").lexically_normal() == (std::filesystem::path(b) / "").lexically_normal();
+}
+
 bool FileDialog::renderLoadDialog(const char* label, std::string& selectedFile)
 {
     // Initialize path on first use
@@ -410,7 +417,7 @@ bool FileDialog::renderSaveAsDialog(const char* label, std::string& filename, co
     return fileSaved;
 }
 
-bool FileDialog::renderTextureDialog(const char* label, std::string& selectedTexture)
+bool FileDialog::renderTextureDialog(const char* label, std::string& selectedTexture, const TextureIndex* index)
 {
     // Initialize path on first use
     if (currentPath.empty())
@@ -460,33 +467,43 @@ bool FileDialog::renderTextureDialog(const char* label, std::string& selectedTex
         ImGui::Separator();
 
         // List directory contents (filtered)
+        bool refreshed = !filesLoaded;
         auto contents = getFilteredDirectoryContents();
 
+        // One entry per texture name, picking the file the renderer would load for it
+        const TextureIndex* textures = index;
+        if (!textures || !isSameDirectory(textures->getDirectory(), currentPath))
+        {
+            if (refreshed || !isSameDirectory(browsedTextures.getDirectory(), currentPath))
+            {
+                browsedTextures.scan(currentPath);
+            }
+            textures = &browsedTextures;
+        }
+
         // Create a child window for scrollable file list
         if (ImGui::BeginChild("TextureFileList", ImVec2(400, 300), true))
         {
             for (const auto& entry : contents)
             {
-                std::string filename = entry.filename().string();
-
                 if (std::filesystem::is_directory(entry))
                 {
                     // Directory
-                    if (ImGui::Selectable(("[DIR] " + filename).c_str()))
+                    if (ImGui::Selectable(("[DIR] " + entry.filename().string()).c_str()))
                     {
                         navigateToPath(entry.string());
                     }
                 }
-                else if (isValidTextureFile(filename))
+            }
+
+            for (const TextureIndex::Texture* texture : textures->getTextures())
+            {
+                // Texture file - show filename without extension
+                if (matchesFilter(texture->name) && ImGui::Selectable(texture->name.c_str()))
                 {
-                    // Texture file - show filename without extension
-                    std::string displayName = std::filesystem::path(filename).stem().string();
-                    if (ImGui::Selectable(displayName.c_str()))
-                    {
-                        selectedTexture = entry.string();
-                        textureSelected = true;
-                        ImGui::CloseCurrentPopup();
-                    }
+                    selectedTexture = texture->paths.front();
+                    textureSelected = true;
+                    ImGui::CloseCurrentPopup();
                 }
             }
         }
@@ -581,12 +598,6 @@ bool FileDialog::isValidMDLFilename(const std::string& filename)
     return true;
 }
 
-bool FileDialog::isValidTextureFile(const std::string& filename)
-{
-    return filename.ends_with(".dds") || filename.ends_with(".tga") || filename.ends_with(".png") ||
-        filename.ends_with(".jpg");
-}
-
 std::string FileDialog::extractModelName(const std::string& filename)
 {
     std::filesystem::path path(filename);
@@ -0,0 +1,214 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "file_watcher.hpp"
+#include <system_error>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    std::string normalizeDirectory(const std::string& directory)
+    {
+        fs::path path = fs::path(directory).lexically_normal();
+        if (!path.has_filename() && path.has_parent_path() && path != path.root_path())
+            path = path.parent_path(); // Drop the trailing separator
+        return path.string();
+    }
+} // namespace
+
+FileWatcher::FileWatcher()
+{
+#ifdef __linux__
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+#ifdef __linux__
+    if (inotifyFd >= 0)
+        ::close(inotifyFd);
+#endif
+}
+
+void FileWatcher::watchDirectory(const std::string& directory)
+{
+    if (directory.empty())
+        return;
+    std::string path = normalizeDirectory(directory);
+    Directory& watched = addDirectory(path);
+    if (watched.allFiles)
+        return;
+    watched.allFiles = true;
+    if (watched.watch < 0)
+        takeSnapshot(path, watched);
+}
+
+void FileWatcher::watchFile(const std::string& path)
+{
+    fs::path file = fs::path(path).lexically_normal();
+    if (!file.has_filename())
+        return;
+    std::string parent = file.has_parent_path() ? file.parent_path().string() : std::string(".");
+    Directory& watched = addDirectory(parent);
+    if (!watched.files.insert(file.filename().string()).second)
+        return;
+    if (watched.watch < 0)
+        takeSnapshot(parent, watched);
+}
+
+void FileWatcher::clear()
+{
+#ifdef __linux__
+    for (const auto& [path, directory] : directories)
+    {
+        if (directory.watch >= 0)
+            inotify_rm_watch(inotifyFd, directory.watch);
+    }
+#endif
+    directories.clear();
+}
+
+FileWatcher::Directory& FileWatcher::addDirectory(const std::string& path)
+{
+    auto [it, inserted] = directories.try_emplace(path);
+    Directory& directory = it->second;
+    if (!inserted)
+        return directory;
+
+#ifdef __linux__
+    // Close-after-write instead of every modification, so half-written files are never reported
+    if (inotifyFd >= 0)
+    {
+        directory.watch = inotify_add_watch(inotifyFd, path.c_str(),
+                                            IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE);
+    }
+#endif
+
+    // Out of watches, or no inotify at all
+    if (directory.watch < 0)
+        takeSnapshot(path, directory);
+    return directory;
+}
+
+bool FileWatcher::isWatched(const Directory& directory, const std::string& name) const
+{
+    return directory.allFiles || directory.files.count(name) > 0;
+}
+
+void FileWatcher::takeSnapshot(const std::string& path, Directory& directory)
+{
+    directory.snapshot.clear();
+    std::error_code ec;
+    for (fs::directory_iterator it(path, ec), end; !ec && it != end; it.increment(ec))
+    {
+        std::string name = it->path().filename().string();
+        if (!isWatched(directory, name) || !it->is_regular_file(ec))
+            continue;
+        fs::file_time_type time = it->last_write_time(ec);
+        if (!ec)
+            directory.snapshot.emplace(name, time);
+    }
+}
+
+std::vector<std::string> FileWatcher::poll()
+{
+    std::set<std::string> changed;
+    readEvents(changed);
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastPoll >= pollInterval)
+    {
+        lastPoll = now;
+        pollDirectories(changed);
+    }
+    return {changed.begin(), changed.end()};
+}
+
+void FileWatcher::readEvents(std::set<std::string>& changed)
+{
+#ifdef __linux__
+    if (inotifyFd < 0)
+        return;
+
+    alignas(inotify_event) char buffer[4096];
+    for (;;)
+    {
+        ssize_t length = ::read(inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0)
+            break; // EAGAIN once the queue is drained
+
+        for (char* p = buffer; p < buffer + length;)
+        {
+            const auto* event = reinterpret_cast<const inotify_event*>(p);
+            p += sizeof(inotify_event) + event->len;
+
+            for (auto& [path, directory] : directories)
+            {
+                if (directory.watch != event->wd)
+                    continue;
+                if (event->mask & IN_IGNORED)
+                {
+                    // The directory itself went away, keep looking for it by polling
+                    directory.watch = -1;
+                    takeSnapshot(path, directory);
+                }
+                else if (event->len > 0 && isWatched(directory, event->name))
+                {
+                    changed.insert((fs::path(path) / event->name).string());
+                }
+                break;
+            }
+        }
+    }
+#else
+    (void)changed;
+#endif
+}
+
+void FileWatcher::pollDirectories(std::set<std::string>& changed)
+{
+    for (auto& [path, directory] : directories)
+    {
+        if (directory.watch >= 0)
+            continue;
+
+        auto previous = std::move(directory.snapshot);
+        takeSnapshot(path, directory);
+
+        for (const auto& [name, time] : directory.snapshot)
+        {
+            auto it = previous.find(name);
+            if (it == previous.end() || it->second != time)
+                changed.insert((fs::path(path) / name).string());
+        }
+        for (const auto& [name, time] : previous)
+        {
+            if (!directory.snapshot.count(name))
+                changed.insert((fs::path(path) / name).string());
+        }
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "lightning.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Upper bounds so hand-edited values cannot blow up the point count
+    constexpr int maxZigZag = 64;
+    constexpr int maxSubdivisions = 6;
+
+    glm::vec3 perpendicularTo(const glm::vec3& direction)
+    {
+        glm::vec3 axis = std::abs(direction.z) < 0.9f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+        return glm::normalize(glm::cross(direction, axis));
+    }
+} // namespace
+
+void generateLightningBolt(const glm::vec3& start, const glm::vec3& end, const LightningParams& params,
+                           std::mt19937& rng, std::vector<glm::vec3>& points)
+{
+    points.clear();
+    glm::vec3 path = end - start;
+    float length = glm::length(path);
+    if (length <= 0.0f)
+    {
+        points.push_back(start);
+        points.push_back(end);
+        return;
+    }
+
+    glm::vec3 direction = path / length;
+    glm::vec3 side = perpendicularTo(direction);
+    glm::vec3 up = glm::cross(direction, side);
+    std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+
+    auto displace = [&](float amount) { return (side * offset(rng) + up * offset(rng)) * amount; };
+
+    // Evenly spaced kinks, each pushed sideways by up to scale times the spacing
+    int zigZag = std::clamp(params.zigZag, 0, maxZigZag);
+    float spacing = length / static_cast<float>(zigZag + 1);
+    points.reserve(static_cast<size_t>(zigZag + 2) << std::clamp(params.subdivisions, 0, maxSubdivisions));
+    points.push_back(start);
+    for (int i = 1; i <= zigZag; ++i)
+    {
+        points.push_back(start + direction * (spacing * static_cast<float>(i)) + displace(spacing * params.scale));
+    }
+    points.push_back(end);
+
+    // Midpoint displacement, offsets shrink with the segments
+    std::vector<glm::vec3> refined;
+    int subdivisions = std::clamp(params.subdivisions, 0, maxSubdivisions);
+    for (int pass = 0; pass < subdivisions; ++pass)
+    {
+        refined.clear();
+        refined.reserve(points.size() * 2);
+        for (size_t i = 0; i + 1 < points.size(); ++i)
+        {
+            float segmentLength = glm::length(points[i + 1] - points[i]);
+            refined.push_back(points[i]);
+            refined.push_back((points[i] + points[i + 1]) * 0.5f + displace(segmentLength * 0.5f * params.scale));
+        }
+        refined.push_back(points.back());
+        points.swap(refined);
+    }
+}
@@ -17,7 +17,10 @@
  */
 
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cctype>
 #include <chrono>
+#include <filesystem>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -29,9 +32,13 @@
 #include "camera.hpp"
 #include "emitter.hpp"
 #include "file_dialog.hpp"
+#include "file_watcher.hpp"
 #include "grab_mode.hpp"
+#include "mdl_loader.hpp"
+#include "mdl_text_view.hpp"
 #include "particle_system.hpp"
 #include "property_editor.hpp"
+#include "resource_manager.hpp"
 #include "toast_manager.hpp"
 
 void errorCallback(int error, const char* description)
@@ -115,6 +122,14 @@ static glm::vec3 g_rotationCurrentRotation = glm::vec3(0.0f);
 static ImVec2 g_rotationStartMouse = ImVec2(0.0f, 0.0f);
 static int g_rotatedEmitter = -1;
 
+// Modification time of a file, the minimum time point if it can't be read
+static std::filesystem::file_time_type getWriteTime(const std::string& path)
+{
+    std::error_code ec;
+    auto time = std::filesystem::last_write_time(path, ec);
+    return ec ? std::filesystem::file_time_type::min() : time;
+}
+
 void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
     g_shiftPressed = (mods & GLFW_MOD_SHIFT) != 0;
@@ -268,17 +283,57 @@ int main()
 
     // Initialize application components
     EmitterEditor emitterEditor;
+    ResourceManager resources; // Declared first so it outlives the renderer that reads from it
     ParticleRenderer particleRenderer;
     PropertyEditor propertyEditor;
     Camera camera;
     ToastManager toastManager;
+    MDLTextView mdlTextView;
+    MDLLoader mdlLoader;
+
+    // The open model is reloaded when another tool writes it, unless it has unsaved edits
+    FileWatcher modelWatcher;
+    std::string watchedFilePath;
+    std::filesystem::file_time_type savedWriteTime = std::filesystem::file_time_type::min();
+    uint64_t savedRevision = emitterEditor.getRevision();
+    bool reloadingModel = false;
+    uint64_t appliedModelNodesRevision = emitterEditor.getModelNodesRevision();
+    std::vector<EmitterNode> reloadPrevious; // Emitters before the reload, to find the ones that changed
+
+    // Our own saves must not read back as external changes
+    auto markSaved = [&](const std::string& path)
+    {
+        savedWriteTime = getWriteTime(path);
+        savedRevision = emitterEditor.getRevision();
+    };
+
+    // Write time of the file a load started on, a write that lands while it is parsed still reads as external
+    std::filesystem::file_time_type loadWriteTime = std::filesystem::file_time_type::min();
+
+    // Save under the file's model name, returns false if nothing was written
+    auto saveModel = [&](const std::string& path)
+    {
+        emitterEditor.setModelName(FileDialog::extractModelName(path));
+        if (!emitterEditor.saveToMDL(path))
+        {
+            toastManager.addToast("Save Failed", path);
+            return false;
+        }
+        markSaved(path);
+        toastManager.addToast("MDL Saved", path);
+        return true;
+    };
 
     g_camera = &camera; // Set global pointer for callbacks
 
     particleRenderer.initialize();
+    particleRenderer.setTextureDiskCacheDirectory(TextureDiskCache::getDefaultDirectory());
     particleRenderer.setTextureDirectory(emitterEditor.getTextureDirectory());
+    propertyEditor.setTextureIndex(&particleRenderer.getTextureIndex());
+    particleRenderer.setResourceManager(&resources);
 
     int selectedEmitter = 0;
+    std::vector<glm::vec4> collisionPlanes; // User planes for bounce/splat, the ground plane is implicit
     bool showMDLText = true;
 
     auto lastTime = std::chrono::high_resolution_clock::now();
@@ -360,6 +415,7 @@ int main()
                 if (g_grabbedEmitter >= 0 && g_grabbedEmitter < static_cast<int>(emitterEditor.getEmitters().size()))
                 {
                     emitterEditor.getEmitters()[g_grabbedEmitter].position = g_grabStartPosition;
+                    emitterEditor.touchEmitter(g_grabbedEmitter);
                 }
                 g_grabMode = GrabMode::None;
                 g_grabbedEmitter = -1;
@@ -439,6 +495,7 @@ int main()
                 {
                     emitterEditor.getEmitters()[g_scaledEmitter].xsize = g_scaleStartSize.x;
                     emitterEditor.getEmitters()[g_scaledEmitter].ysize = g_scaleStartSize.y;
+                    emitterEditor.touchEmitter(g_scaledEmitter);
                 }
                 g_scaleMode = ScaleMode::None;
                 g_scaledEmitter = -1;
@@ -485,6 +542,7 @@ int main()
                 if (g_rotatedEmitter >= 0 && g_rotatedEmitter < static_cast<int>(emitterEditor.getEmitters().size()))
                 {
                     emitterEditor.getEmitters()[g_rotatedEmitter].rotationAngles = g_rotationStartRotation;
+                    emitterEditor.touchEmitter(g_rotatedEmitter);
                 }
                 g_rotationMode = RotationMode::None;
                 g_rotatedEmitter = -1;
@@ -541,11 +599,9 @@ int main()
         {
             if (!currentFilePath.empty())
             {
-                // Quick save to existing file
-                std::string modelName = FileDialog::extractModelName(currentFilePath);
-                emitterEditor.setModelName(modelName);
-                emitterEditor.saveToMDL(currentFilePath);
-                toastManager.addToast("MDL Saved", currentFilePath);
+                // Quick save to existing file, a refused save asks for a new one
+                if (!saveModel(currentFilePath))
+                    openSaveAsDialog = true;
             }
             else
             {
@@ -576,6 +632,7 @@ int main()
             g_ctrlN_pressed)
         {
             emitterEditor.resetToNew();
+            particleRenderer.setModelNodes(emitterEditor.getModelNodes());
             camera.reset();
             selectedEmitter = 0;
             currentFilePath = ""; // Clear file path for new file
@@ -623,6 +680,7 @@ int main()
                 if (ImGui::MenuItem("New MDL", "Ctrl+N"))
                 {
                     emitterEditor.resetToNew();
+                    particleRenderer.setModelNodes(emitterEditor.getModelNodes());
                     camera.reset();
                     selectedEmitter = 0;
                     currentFilePath = ""; // Clear file path for new file
@@ -636,11 +694,9 @@ int main()
                 {
                     if (!currentFilePath.empty())
                     {
-                        // Quick save to existing file
-                        std::string modelName = FileDialog::extractModelName(currentFilePath);
-                        emitterEditor.setModelName(modelName);
-                        emitterEditor.saveToMDL(currentFilePath);
-                        toastManager.addToast("MDL Saved", currentFilePath);
+                        // Quick save to existing file, a refused save asks for a new one
+                        if (!saveModel(currentFilePath))
+                            openSaveAsDialog = true;
                     }
                     else
                     {
@@ -652,6 +708,11 @@ int main()
                 {
                     openSaveAsDialog = true;
                 }
+                bool saveBinary = emitterEditor.getSaveFormat() == MDLFormat::Binary;
+                if (ImGui::MenuItem("Save as Binary", nullptr, &saveBinary, emitterEditor.canSaveBinary()))
+                {
+                    emitterEditor.setSaveFormat(saveBinary ? MDLFormat::Binary : MDLFormat::Ascii);
+                }
                 ImGui::Separator();
                 if (ImGui::MenuItem("Exit", "Ctrl+Q"))
                 {
@@ -739,31 +800,125 @@ int main()
         // File dialogs need to be rendered inside the docking space
         if (FileDialog::renderLoadDialog("Load MDL File", loadFile))
         {
-            emitterEditor.loadFromMDL(loadFile);
+            // Parse on a worker thread, textures resolve against the new model's directory while it loads
+            loadWriteTime = getWriteTime(loadFile);
+            mdlLoader.start(loadFile);
+            reloadingModel = false;
+            particleRenderer.setTextureDirectory(std::filesystem::path(loadFile).parent_path().string());
+        }
+
+        // Decoding runs on worker threads, so every texture can be requested as soon as its name is parsed
+        for (const auto& textureName : mdlLoader.takeTextureNames())
+        {
+            particleRenderer.prefetchTexture(textureName);
+        }
+
+        // Re-parse the open model when it was written by another tool
+        bool modelChanged = false;
+        if (watchedFilePath != currentFilePath)
+        {
+            modelWatcher.clear();
+            if (!currentFilePath.empty())
+                modelWatcher.watchFile(currentFilePath);
+            watchedFilePath = currentFilePath;
+            // Writes from before the watch was set up, while the file was still loading, have no event
+            modelChanged = !currentFilePath.empty() && getWriteTime(currentFilePath) != savedWriteTime;
+        }
+        // Not polled during a load, so changes made meanwhile stay queued and are handled once it finishes
+        if (!mdlLoader.isLoading() && (!modelWatcher.poll().empty() || modelChanged))
+        {
+            auto writeTime = getWriteTime(currentFilePath);
+            if (writeTime == std::filesystem::file_time_type::min() || writeTime == savedWriteTime)
+            {
+                // Deleted, or our own save
+            }
+            else if (emitterEditor.getRevision() != savedRevision)
+            {
+                savedWriteTime = writeTime; // Warn once per external write
+                toastManager.addToast("MDL Changed On Disk", "Unsaved edits kept, reload to discard them");
+            }
+            else
+            {
+                reloadPrevious = emitterEditor.getEmitters();
+                reloadingModel = true;
+                loadWriteTime = writeTime;
+                mdlLoader.start(currentFilePath);
+            }
+        }
+
+        switch (mdlLoader.collect(emitterEditor))
+        {
+        case MDLLoader::Status::Succeeded:
+        {
             particleRenderer.setTextureDirectory(emitterEditor.getTextureDirectory());
-            selectedEmitter = 0;
-            currentFilePath = loadFile; // Remember loaded file path
+            particleRenderer.setModelNodes(emitterEditor.getModelNodes());
+            if (reloadingModel)
+            {
+                // Only emitters that were edited restart their simulation
+                const auto& emitters = emitterEditor.getEmitters();
+                int reset = particleRenderer.reloadEmitters(reloadPrevious, emitters);
+                if (selectedEmitter >= static_cast<int>(emitters.size()))
+                    selectedEmitter = 0;
+                toastManager.addToast("MDL Reloaded", std::to_string(reset) + " of " +
+                                                          std::to_string(emitters.size()) + " emitters changed");
+            }
+            else
+            {
+                selectedEmitter = 0;
+            }
+            reloadingModel = false;
+            reloadPrevious.clear();
+            // Remember loaded file path, models from archives have to be saved to a new file
+            currentFilePath = mdlLoader.isFromArchive() ? "" : mdlLoader.getFilename();
+            markSaved(currentFilePath);
+            if (!currentFilePath.empty())
+                savedWriteTime = loadWriteTime;
             // Update the last saved filename when loading a file
-            std::string modelName = FileDialog::extractModelName(loadFile);
+            std::string modelName = FileDialog::extractModelName(mdlLoader.getFilename());
             FileDialog::setLastSavedFilename(modelName);
+            break;
+        }
+        case MDLLoader::Status::Failed:
+            particleRenderer.setTextureDirectory(emitterEditor.getTextureDirectory());
+            particleRenderer.setModelNodes(emitterEditor.getModelNodes());
+            toastManager.addToast(reloadingModel ? "Reload Failed" : "Load Failed", mdlLoader.getFilename());
+            reloadingModel = false;
+            reloadPrevious.clear();
+            break;
+        case MDLLoader::Status::Cancelled:
+            particleRenderer.setTextureDirectory(emitterEditor.getTextureDirectory());
+            reloadingModel = false;
+            reloadPrevious.clear();
+            break;
+        default:
+            break;
+        }
+
+        if (mdlLoader.isLoading())
+        {
+            ImGuiViewport* mainViewport = ImGui::GetMainViewport();
+            ImGui::SetNextWindowPos(mainViewport->GetCenter(), ImGuiCond_Always, ImVec2(0.5f, 0.5f));
+            ImGui::Begin("Loading MDL", nullptr,
+                         ImGuiWindowFlags_NoDocking | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_AlwaysAutoResize);
+            ImGui::Text("%s", mdlLoader.getFilename().c_str());
+            ImGui::ProgressBar(mdlLoader.getProgress(), ImVec2(300.0f, 0.0f));
+            if (ImGui::Button("Cancel"))
+            {
+                mdlLoader.cancel();
+            }
+            ImGui::End();
         }
 
         if (FileDialog::renderSaveDialog("Save MDL File", saveFile))
         {
-            std::string modelName = FileDialog::extractModelName(saveFile);
-            emitterEditor.setModelName(modelName);
-            emitterEditor.saveToMDL(saveFile);
-            currentFilePath = saveFile; // Remember saved file path
-            toastManager.addToast("MDL Saved", saveFile);
+            if (saveModel(saveFile))
+                currentFilePath = saveFile; // Remember saved file path
         }
 
         if (FileDialog::renderSaveAsDialog("Save As MDL File", saveFile, currentFilePath))
         {
-            std::string modelName = FileDialog::extractModelName(saveFile);
-            emitterEditor.setModelName(modelName);
-            emitterEditor.saveToMDL(saveFile);
-            currentFilePath = saveFile; // Update current file path to new location
-            toastManager.addToast("MDL Saved", saveFile);
+            if (saveModel(saveFile))
+                currentFilePath = saveFile; // Update current file path to new location
         }
 
         // About modal dialog
@@ -802,6 +957,7 @@ int main()
         ImGui::End();
 
         // Property Editor Panel
+        propertyEditor.setGradientTexture(particleRenderer.getGradientTexture(selectedEmitter));
         propertyEditor.render(emitterEditor, selectedEmitter);
 
         // Particle Preview Panel
@@ -818,6 +974,172 @@ int main()
         {
             camera.reset();
         }
+        ImGui::SameLine();
+        if (ImGui::Button("Retrigger"))
+        {
+            particleRenderer.retrigger();
+        }
+        ImGui::SetItemTooltip("Replay the bursts of Explosion and Single emitters");
+        ImGui::SameLine();
+        if (ImGui::Button("Collision Planes"))
+        {
+            ImGui::OpenPopup("CollisionPlanes");
+        }
+        ImGui::SetItemTooltip("Planes that bouncing and splatting particles hit, in addition to the ground (Z=0)");
+
+        if (ImGui::BeginPopup("CollisionPlanes"))
+        {
+            bool planesChanged = false;
+            for (size_t i = 0; i < collisionPlanes.size(); ++i)
+            {
+                ImGui::PushID(static_cast<int>(i));
+                planesChanged |= ImGui::DragFloat3("Normal", &collisionPlanes[i].x, 0.01f, -1.0f, 1.0f);
+                ImGui::SameLine();
+                planesChanged |= ImGui::DragFloat("Offset", &collisionPlanes[i].w, 0.05f);
+                ImGui::SameLine();
+                if (ImGui::Button("Remove"))
+                {
+                    collisionPlanes.erase(collisionPlanes.begin() + i);
+                    planesChanged = true;
+                    ImGui::PopID();
+                    break;
+                }
+                ImGui::PopID();
+            }
+            if (ImGui::Button("Add Plane"))
+            {
+                collisionPlanes.emplace_back(0.0f, 0.0f, 1.0f, 0.0f);
+                planesChanged = true;
+            }
+            if (planesChanged)
+            {
+                particleRenderer.setCollisionPlanes(collisionPlanes);
+            }
+            ImGui::EndPopup();
+        }
+
+        ImGui::SameLine();
+        if (ImGui::Button("Texture Cache"))
+        {
+            ImGui::OpenPopup("TextureCache");
+        }
+        if (ImGui::BeginPopup("TextureCache"))
+        {
+            TextureCache::Stats stats = particleRenderer.getTextureCacheStats();
+            ImGui::Text("Textures: %zu resident / %zu known", stats.resident, stats.entries);
+            ImGui::Text("GPU memory: %.1f MB", stats.bytes / (1024.0 * 1024.0));
+            ImGui::Text("Hit rate: %.1f%% (%llu requests)", stats.getHitRate() * 100.0f,
+                        static_cast<unsigned long long>(stats.hits + stats.misses));
+
+            int budgetMB = static_cast<int>(stats.budget / (1024 * 1024));
+            if (ImGui::DragInt("Budget (MB)", &budgetMB, 4.0f, 16, 4096))
+            {
+                particleRenderer.setTextureCacheBudget(static_cast<size_t>(budgetMB) * 1024 * 1024);
+            }
+            ImGui::SetItemTooltip("Textures not used by any emitter are evicted, oldest first, above this size");
+
+            ImGui::Separator();
+            const TextureDiskCache* diskCache = particleRenderer.getTextureDiskCache();
+            bool diskCacheEnabled = diskCache != nullptr;
+            if (ImGui::Checkbox("Disk Cache", &diskCacheEnabled))
+            {
+                particleRenderer.setTextureDiskCacheDirectory(
+                    diskCacheEnabled ? TextureDiskCache::getDefaultDirectory() : std::string());
+                diskCache = particleRenderer.getTextureDiskCache();
+            }
+            ImGui::SetItemTooltip("Keep decoded textures on disk so they load without decoding next time");
+            if (diskCache)
+            {
+                ImGui::TextDisabled("%s", diskCache->getDirectory().c_str());
+                if (ImGui::Button("Clear Disk Cache"))
+                {
+                    diskCache->clear();
+                }
+            }
+            ImGui::EndPopup();
+        }
+
+        ImGui::SameLine();
+        if (ImGui::Button("Archives"))
+        {
+            ImGui::OpenPopup("Archives");
+        }
+        ImGui::SetItemTooltip("Game data and hak archives that textures and models are read from");
+        if (ImGui::BeginPopup("Archives"))
+        {
+            static char mountPath[512] = "";
+            ImGui::SetNextItemWidth(400.0f);
+            ImGui::InputText("##mountPath", mountPath, sizeof(mountPath));
+            ImGui::SameLine();
+            if (ImGui::Button("Mount") && mountPath[0] != '\0')
+            {
+                if (resources.mount(mountPath))
+                    toastManager.addToast("Archive Mounted", mountPath);
+                else
+                    toastManager.addToast("Mount Failed", mountPath);
+            }
+            ImGui::SetItemTooltip(".erf, .hak or .mod archive, or a .key file with its BIFs");
+
+            // Highest precedence first
+            ImGui::Text("Mounted (later archives override earlier ones):");
+            const auto& mounts = resources.getMounts();
+            for (size_t i = mounts.size(); i-- > 0;)
+            {
+                ImGui::PushID(static_cast<int>(i));
+                if (ImGui::SmallButton("Unmount"))
+                {
+                    resources.unmount(i);
+                    ImGui::PopID();
+                    break;
+                }
+                ImGui::SameLine();
+                ImGui::Text("%s (%zu resources)", mounts[i].path.c_str(), mounts[i].resourceCount);
+                ImGui::PopID();
+            }
+
+            // Listing a KEY touches every entry, only do it when the mounts change
+            static std::vector<std::string> archiveModels;
+            static uint64_t archiveModelsRevision = UINT64_MAX;
+            if (archiveModelsRevision != resources.getRevision())
+            {
+                archiveModels = resources.list(ResourceType::MDL);
+                archiveModelsRevision = resources.getRevision();
+            }
+
+            ImGui::Separator();
+            static char modelFilter[64] = "";
+            ImGui::InputText("Filter Models", modelFilter, sizeof(modelFilter));
+            std::string filter = modelFilter;
+            std::transform(filter.begin(), filter.end(), filter.begin(),
+                           [](unsigned char c) { return std::tolower(c); }); // Resrefs are stored lowercase
+            std::vector<const std::string*> shownModels;
+            for (const auto& resref : archiveModels)
+            {
+                if (resref.find(filter) != std::string::npos)
+                    shownModels.push_back(&resref);
+            }
+
+            if (ImGui::BeginChild("ArchiveModels", ImVec2(400, 200), true))
+            {
+                ImGuiListClipper clipper;
+                clipper.Begin(static_cast<int>(shownModels.size()));
+                while (clipper.Step())
+                {
+                    for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
+                    {
+                        const std::string& resref = *shownModels[i];
+                        if (ImGui::Selectable(resref.c_str()))
+                        {
+                            mdlLoader.start(resref + ".mdl", resources.find(resref, ResourceType::MDL));
+                            reloadingModel = false;
+                            ImGui::CloseCurrentPopup();
+                        }
+                    }
+                }
+            }
+            ImGui::EndChild();
+            ImGui::EndPopup();
+        }
 
         // Get available space for 3D viewport
         ImVec2 previewSize = ImGui::GetContentRegionAvail();
@@ -828,6 +1150,13 @@ int main()
             glm::mat4 projection = camera.getProjectionMatrix(previewSize.x / previewSize.y);
             particleRenderer.setCamera(view, projection);
 
+            // Model node parents follow emitters that were renamed
+            if (emitterEditor.getModelNodesRevision() != appliedModelNodesRevision)
+            {
+                particleRenderer.setModelNodes(emitterEditor.getModelNodes());
+                appliedModelNodesRevision = emitterEditor.getModelNodesRevision();
+            }
+
             // Render to framebuffer texture
             particleRenderer.renderToTexture(emitterEditor.getEmitters(), deltaTime, (int)previewSize.x,
                                              (int)previewSize.y, selectedEmitter);
@@ -839,7 +1168,7 @@ int main()
                 glBindFramebuffer(GL_FRAMEBUFFER, particleRenderer.getFramebuffer());
                 glViewport(0, 0, (int)previewSize.x, (int)previewSize.y);
 
-                glm::vec3 emitterPos = emitterEditor.getEmitters()[g_grabbedEmitter].position;
+                glm::vec3 emitterPos = particleRenderer.getEmitterWorldPosition(g_grabbedEmitter);
                 particleRenderer.renderGrabModeIndicator((int)previewSize.x, (int)previewSize.y, g_grabMode,
                                                          emitterPos);
 
@@ -853,7 +1182,7 @@ int main()
                 glBindFramebuffer(GL_FRAMEBUFFER, particleRenderer.getFramebuffer());
                 glViewport(0, 0, (int)previewSize.x, (int)previewSize.y);
 
-                glm::vec3 emitterPos = emitterEditor.getEmitters()[g_scaledEmitter].position;
+                glm::vec3 emitterPos = particleRenderer.getEmitterWorldPosition(g_scaledEmitter);
                 glm::vec2 currentSize = glm::vec2(emitterEditor.getEmitters()[g_scaledEmitter].xsize,
                                                   emitterEditor.getEmitters()[g_scaledEmitter].ysize);
                 particleRenderer.renderScaleModeIndicator((int)previewSize.x, (int)previewSize.y, g_scaleMode,
@@ -869,7 +1198,7 @@ int main()
                 glBindFramebuffer(GL_FRAMEBUFFER, particleRenderer.getFramebuffer());
                 glViewport(0, 0, (int)previewSize.x, (int)previewSize.y);
 
-                glm::vec3 emitterPos = emitterEditor.getEmitters()[g_rotatedEmitter].position;
+                glm::vec3 emitterPos = particleRenderer.getEmitterWorldPosition(g_rotatedEmitter);
                 particleRenderer.renderRotationModeIndicator((int)previewSize.x, (int)previewSize.y, g_rotationMode,
                                                              emitterPos);
 
@@ -906,8 +1235,11 @@ int main()
                         if (g_grabbedEmitter >= 0 &&
                             g_grabbedEmitter < static_cast<int>(emitterEditor.getEmitters().size()))
                         {
+                            // The position is relative to the emitter's parent
                             emitterEditor.getEmitters()[g_grabbedEmitter].position =
-                                g_grabStartPosition + constrainedDelta;
+                                g_grabStartPosition +
+                                particleRenderer.worldToParentOffset(g_grabbedEmitter, constrainedDelta);
+                            emitterEditor.touchEmitter(g_grabbedEmitter);
                         }
                     }
 
@@ -922,6 +1254,7 @@ int main()
                             g_grabbedEmitter < static_cast<int>(emitterEditor.getEmitters().size()))
                         {
                             emitterEditor.getEmitters()[g_grabbedEmitter].position = g_grabStartPosition;
+                            emitterEditor.touchEmitter(g_grabbedEmitter);
                         }
                         g_grabMode = GrabMode::None;
                         g_grabbedEmitter = -1;
@@ -945,6 +1278,7 @@ int main()
                         {
                             emitterEditor.getEmitters()[g_scaledEmitter].xsize = newSize.x;
                             emitterEditor.getEmitters()[g_scaledEmitter].ysize = newSize.y;
+                            emitterEditor.touchEmitter(g_scaledEmitter);
                         }
                     }
 
@@ -960,6 +1294,7 @@ int main()
                         {
                             emitterEditor.getEmitters()[g_scaledEmitter].xsize = g_scaleStartSize.x;
                             emitterEditor.getEmitters()[g_scaledEmitter].ysize = g_scaleStartSize.y;
+                            emitterEditor.touchEmitter(g_scaledEmitter);
                         }
                         g_scaleMode = ScaleMode::None;
                         g_scaledEmitter = -1;
@@ -982,7 +1317,9 @@ int main()
                             g_rotatedEmitter < static_cast<int>(emitterEditor.getEmitters().size()))
                         {
                             emitterEditor.getEmitters()[g_rotatedEmitter].rotationAngles =
-                                g_rotationStartRotation + rotationDelta;
+                                particleRenderer.rotateInWorld(g_rotatedEmitter, g_rotationStartRotation,
+                                                               rotationDelta);
+                            emitterEditor.touchEmitter(g_rotatedEmitter);
                         }
                     }
 
@@ -997,6 +1334,7 @@ int main()
                             g_rotatedEmitter < static_cast<int>(emitterEditor.getEmitters().size()))
                         {
                             emitterEditor.getEmitters()[g_rotatedEmitter].rotationAngles = g_rotationStartRotation;
+                            emitterEditor.touchEmitter(g_rotatedEmitter);
                         }
                         g_rotationMode = RotationMode::None;
                         g_rotatedEmitter = -1;
@@ -1105,17 +1443,7 @@ int main()
         // MDL Text View Panel
         if (showMDLText)
         {
-            ImGui::Begin("MDL Text View", &showMDLText);
-
-            std::string mdlText = emitterEditor.generateMDLText();
-            ImGui::TextUnformatted(mdlText.c_str());
-
-            if (ImGui::Button("Copy to Clipboard"))
-            {
-                ImGui::SetClipboardText(mdlText.c_str());
-            }
-
-            ImGui::End();
+            mdlTextView.render(emitterEditor, &showMDLText);
         }
 
         // Render toast notifications (should be rendered last to appear on top)
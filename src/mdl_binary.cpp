@@ -0,0 +1,760 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "mdl_binary.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include "emitter_fields.hpp"
+
+// All multi-byte values in compiled models are little endian, as are all platforms we build for.
+// Offsets inside the model data are relative to the end of the 12 byte file header.
+
+namespace
+{
+    constexpr size_t FILE_HEADER_SIZE = 12;
+    constexpr size_t GEOMETRY_HEADER_SIZE = 112;
+    constexpr size_t MODEL_HEADER_SIZE = GEOMETRY_HEADER_SIZE + 120;
+    constexpr size_t NODE_HEADER_SIZE = 112;
+    constexpr size_t EMITTER_HEADER_SIZE = 216;
+    constexpr size_t CONTROLLER_KEY_SIZE = 12;
+    constexpr size_t MAX_CONTROLLER_INDEX = 0xFFFF;
+
+    constexpr uint8_t GEOMETRY_TYPE_MODEL = 2;
+    constexpr uint8_t CLASSIFICATION_EFFECT = 0x01;
+
+    // Node header flags
+    constexpr uint32_t NODE_HAS_HEADER = 0x001;
+    constexpr uint32_t NODE_HAS_EMITTER = 0x004;
+    constexpr uint32_t NODE_TYPE_DUMMY = NODE_HAS_HEADER;
+    constexpr uint32_t NODE_TYPE_EMITTER = NODE_HAS_HEADER | NODE_HAS_EMITTER;
+
+    // Emitter header flags
+    constexpr uint32_t EMITTER_P2P = 0x0001;
+    constexpr uint32_t EMITTER_P2P_BEZIER = 0x0002;
+    constexpr uint32_t EMITTER_AFFECTED_BY_WIND = 0x0004;
+    constexpr uint32_t EMITTER_TINTED = 0x0008;
+    constexpr uint32_t EMITTER_BOUNCE = 0x0010;
+    constexpr uint32_t EMITTER_RANDOM = 0x0020;
+    constexpr uint32_t EMITTER_INHERIT = 0x0040;
+    constexpr uint32_t EMITTER_INHERIT_VEL = 0x0080;
+    constexpr uint32_t EMITTER_INHERIT_LOCAL = 0x0100;
+    constexpr uint32_t EMITTER_SPLAT = 0x0200;
+    constexpr uint32_t EMITTER_INHERIT_PART = 0x0400;
+
+    // Controller types
+    constexpr uint32_t CONTROLLER_POSITION = 8;
+    constexpr uint32_t CONTROLLER_ORIENTATION = 20;
+
+    // Emitter controllers that map one-to-one onto a field table entry
+    struct EmitterController
+    {
+        uint32_t type;
+        const char* field;
+    };
+
+    constexpr EmitterController emitterControllers[] = {
+        {80, "alphaEnd"},
+        {84, "alphaStart"},
+        {88, "birthrate"},
+        {92, "bounce_co"},
+        {96, "colorEnd"},
+        {108, "colorStart"},
+        {120, "combinetime"},
+        {124, "drag"},
+        {128, "fps"},
+        {132, "frameEnd"},
+        {136, "frameStart"},
+        {140, "grav"},
+        {144, "lifeExp"},
+        {148, "mass"},
+        {160, "particleRot"},
+        {168, "sizeStart"},
+        {172, "sizeEnd"},
+        {176, "sizeStart_y"},
+        {180, "sizeEnd_y"},
+        {184, "spread"},
+        {188, "threshold"},
+        {192, "velocity"},
+        {196, "xsize"},
+        {200, "ysize"},
+        {204, "blurlength"},
+        {208, "lightningDelay"},
+        {212, "lightningRadius"},
+        {216, "lightningScale"},
+        {220, "lightningSubDiv"},
+        {224, "lightningZigZag"},
+        {284, "colorMid"},
+        {464, "alphaMid"},
+        {480, "percentStart"},
+        {481, "percentMid"},
+        {482, "percentEnd"},
+        {484, "sizeMid"},
+        {488, "sizeMid_y"},
+    };
+
+    const EmitterController* findController(uint32_t type)
+    {
+        for (const auto& controller : emitterControllers)
+        {
+            if (controller.type == type)
+                return &controller;
+        }
+        return nullptr;
+    }
+
+    // Bounds-checked reads from the model data block
+    class BinaryReader
+    {
+    public:
+        BinaryReader(const unsigned char* data, size_t size) : data(data), size(size) {}
+
+        bool has(size_t offset, size_t length) const { return offset <= size && length <= size - offset; }
+
+        template <typename T>
+        T read(size_t offset) const
+        {
+            T value{};
+            if (has(offset, sizeof(T)))
+            {
+                std::memcpy(&value, data + offset, sizeof(T));
+            }
+            return value;
+        }
+
+        // Fixed-size, NUL padded string field
+        std::string readString(size_t offset, size_t length) const
+        {
+            if (!has(offset, length))
+                return {};
+            const char* start = reinterpret_cast<const char*>(data + offset);
+            return std::string(start, strnlen(start, length));
+        }
+
+    private:
+        const unsigned char* data;
+        size_t size;
+    };
+
+    struct ArrayDef
+    {
+        uint32_t offset;
+        uint32_t count;
+    };
+
+    ArrayDef readArrayDef(const BinaryReader& reader, size_t offset)
+    {
+        return {reader.read<uint32_t>(offset), reader.read<uint32_t>(offset + 4)};
+    }
+
+    template <typename Enum, size_t N>
+    void assignEnumByName(Enum& value, const std::array<std::string_view, N>& names, const std::string& name)
+    {
+        auto it = std::find(names.begin(), names.end(), name);
+        if (it != names.end())
+        {
+            value = static_cast<Enum>(it - names.begin());
+        }
+    }
+
+    void applyControllerValue(const EmitterField& field, EmitterNode& emitter, const float* values, int columns)
+    {
+        std::visit(
+            [&](auto member)
+            {
+                auto& value = emitter.*member;
+                using T = std::remove_reference_t<decltype(value)>;
+                if constexpr (std::is_same_v<T, float>)
+                {
+                    value = values[0] / field.scale;
+                }
+                else if constexpr (std::is_same_v<T, glm::vec3>)
+                {
+                    if (columns >= 3)
+                        value = glm::vec3(values[0], values[1], values[2]);
+                }
+            },
+            field.member);
+    }
+
+    void readEmitterHeader(const BinaryReader& reader, size_t offset, EmitterNode& emitter)
+    {
+        emitter.deadspace = reader.read<float>(offset + 0);
+        emitter.blastRadius = reader.read<float>(offset + 4);
+        emitter.blastLength = reader.read<float>(offset + 8);
+        emitter.xgrid = static_cast<int>(reader.read<uint32_t>(offset + 12));
+        emitter.ygrid = static_cast<int>(reader.read<uint32_t>(offset + 16));
+        emitter.spawntype = static_cast<SpawnType>(reader.read<uint32_t>(offset + 20));
+
+        assignEnumByName(emitter.update, updateTypeNames, reader.readString(offset + 24, 32));
+        assignEnumByName(emitter.render, renderTypeNames, reader.readString(offset + 56, 32));
+        assignEnumByName(emitter.blend, blendTypeNames, reader.readString(offset + 88, 32));
+
+        emitter.texture = reader.readString(offset + 120, 64);
+        if (emitter.texture == "NULL")
+        {
+            emitter.texture.clear();
+        }
+
+        emitter.twosidedtex = reader.read<uint32_t>(offset + 200) != 0;
+        emitter.loop = reader.read<uint32_t>(offset + 204) != 0;
+        emitter.renderorder = reader.read<uint16_t>(offset + 208);
+
+        uint32_t flags = reader.read<uint32_t>(offset + 212);
+        emitter.p2p = (flags & EMITTER_P2P) != 0;
+        emitter.p2p_sel = (flags & EMITTER_P2P_BEZIER) ? 1 : 2;
+        emitter.affectedByWind = (flags & EMITTER_AFFECTED_BY_WIND) != 0;
+        emitter.m_isTinted = (flags & EMITTER_TINTED) != 0;
+        emitter.bounce = (flags & EMITTER_BOUNCE) != 0;
+        emitter.random = (flags & EMITTER_RANDOM) != 0;
+        emitter.inherit = (flags & EMITTER_INHERIT) != 0;
+        emitter.inheritvel = (flags & EMITTER_INHERIT_VEL) != 0;
+        emitter.inherit_local = (flags & EMITTER_INHERIT_LOCAL) != 0;
+        emitter.splat = (flags & EMITTER_SPLAT) != 0;
+        emitter.inherit_part = (flags & EMITTER_INHERIT_PART) != 0;
+    }
+
+    // Calls fn(type, rows, times, values, columns) for every well-formed controller of a node
+    template <typename Fn>
+    void forEachController(const BinaryReader& reader, size_t nodeOffset, Fn&& fn)
+    {
+        ArrayDef keys = readArrayDef(reader, nodeOffset + 84);
+        ArrayDef data = readArrayDef(reader, nodeOffset + 96);
+        if (!reader.has(keys.offset, static_cast<size_t>(keys.count) * CONTROLLER_KEY_SIZE) ||
+            !reader.has(data.offset, static_cast<size_t>(data.count) * sizeof(float)))
+        {
+            return;
+        }
+
+        std::vector<float> values(data.count);
+        for (uint32_t i = 0; i < data.count; ++i)
+        {
+            values[i] = reader.read<float>(data.offset + i * sizeof(float));
+        }
+
+        for (uint32_t k = 0; k < keys.count; ++k)
+        {
+            size_t keyOffset = keys.offset + k * CONTROLLER_KEY_SIZE;
+            uint32_t type = reader.read<uint32_t>(keyOffset);
+            int rows = reader.read<uint16_t>(keyOffset + 4);
+            size_t timeIndex = reader.read<uint16_t>(keyOffset + 6);
+            size_t dataIndex = reader.read<uint16_t>(keyOffset + 8);
+            int columns = reader.read<uint8_t>(keyOffset + 10) & 0x0F; // High bits mark bezier keys
+
+            if (rows <= 0 || columns <= 0 || timeIndex + rows > values.size() ||
+                dataIndex + static_cast<size_t>(rows) * columns > values.size())
+            {
+                continue;
+            }
+            fn(type, rows, &values[timeIndex], &values[dataIndex], columns);
+        }
+    }
+
+    void readControllers(const BinaryReader& reader, size_t nodeOffset, EmitterNode& emitter)
+    {
+        forEachController(
+            reader, nodeOffset,
+            [&](uint32_t type, int rows, const float* times, const float* first, int columns)
+            {
+                if (type == CONTROLLER_POSITION && columns >= 3)
+                {
+                    emitter.position = glm::vec3(first[0], first[1], first[2]);
+                    if (rows > 1)
+                    {
+                        emitter.positionKeys.clear();
+                        for (int r = 0; r < rows; ++r)
+                        {
+                            const float* row = first + r * columns;
+                            emitter.positionKeys.keyframes.emplace_back(times[r], glm::vec3(row[0], row[1], row[2]));
+                        }
+                    }
+                }
+                else if (type == CONTROLLER_ORIENTATION && columns >= 4)
+                {
+                    // Stored as a quaternion (x, y, z, w)
+                    glm::quat quat(first[3], first[0], first[1], first[2]);
+                    emitter.rotationAngles = glm::degrees(glm::eulerAngles(quat));
+                    if (rows > 1)
+                    {
+                        emitter.orientationKeys.clear();
+                        for (int r = 0; r < rows; ++r)
+                        {
+                            const float* row = first + r * columns;
+                            glm::quat key(row[3], row[0], row[1], row[2]);
+                            emitter.orientationKeys.keyframes.emplace_back(times[r], glm::normalize(key));
+                        }
+                    }
+                }
+                else if (const EmitterController* controller = findController(type))
+                {
+                    if (const EmitterField* field = findEmitterField(controller->field))
+                    {
+                        applyControllerValue(*field, emitter, first, columns);
+                    }
+                }
+            });
+    }
+
+    void appendFloat(std::string& out, float value)
+    {
+        char buffer[64];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed);
+        out.append(buffer, result.ptr);
+    }
+
+    // Dummies keep only their transform, written as the node text an ASCII model would have
+    void readDummy(const BinaryReader& reader, size_t nodeOffset, ModelNode& dummy)
+    {
+        forEachController(reader, nodeOffset,
+                          [&](uint32_t type, int, const float*, const float* first, int columns)
+                          {
+                              if (type == CONTROLLER_POSITION && columns >= 3)
+                                  dummy.position = glm::vec3(first[0], first[1], first[2]);
+                              else if (type == CONTROLLER_ORIENTATION && columns >= 4)
+                                  dummy.orientation = glm::normalize(glm::quat(first[3], first[0], first[1], first[2]));
+                          });
+
+        glm::vec3 axis(0.0f, 0.0f, 1.0f);
+        float angle = glm::angle(dummy.orientation);
+        if (angle < 0.001f)
+            angle = 0.0f;
+        else
+            axis = glm::axis(dummy.orientation);
+
+        dummy.body = "  position ";
+        for (int i = 0; i < 3; ++i)
+        {
+            appendFloat(dummy.body, dummy.position[i]);
+            dummy.body += i < 2 ? ' ' : '\n';
+        }
+        dummy.body += "  orientation ";
+        for (int i = 0; i < 3; ++i)
+        {
+            appendFloat(dummy.body, axis[i]);
+            dummy.body += ' ';
+        }
+        appendFloat(dummy.body, angle);
+        dummy.body += '\n';
+    }
+
+    struct PendingNode
+    {
+        size_t offset;
+        std::string parentName;
+    };
+
+    // Reads one node and queues its children. The tree is walked with an explicit stack, so a long chain of
+    // children in a malformed file cannot overflow the call stack.
+    void readNode(const BinaryReader& reader, const PendingNode& node, BinaryModel& model,
+                  std::vector<PendingNode>& pending, std::unordered_set<size_t>& visited)
+    {
+        size_t offset = node.offset;
+        const std::string& parentName = node.parentName;
+        if (!reader.has(offset, NODE_HEADER_SIZE))
+        {
+            return;
+        }
+
+        std::string name = reader.readString(offset + 32, 32);
+        uint32_t flags = reader.read<uint32_t>(offset + 108);
+
+        if ((flags & NODE_HAS_EMITTER) && reader.has(offset + NODE_HEADER_SIZE, EMITTER_HEADER_SIZE))
+        {
+            EmitterNode emitter;
+            applyEmitterFieldDefaults(emitter);
+            emitter.name = name;
+            emitter.parent = parentName;
+            readEmitterHeader(reader, offset + NODE_HEADER_SIZE, emitter);
+            readControllers(reader, offset, emitter);
+            model.emitters.push_back(std::move(emitter));
+        }
+        else if (flags == NODE_TYPE_DUMMY)
+        {
+            ModelNode dummy;
+            dummy.type = "dummy";
+            dummy.name = name;
+            dummy.parent = parentName;
+            readDummy(reader, offset, dummy);
+            model.dummies.push_back(std::move(dummy));
+        }
+        else
+        {
+            model.complete = false; // Mesh, light or other geometry, only its children are read
+        }
+
+        ArrayDef children = readArrayDef(reader, offset + 72);
+        if (!reader.has(children.offset, static_cast<size_t>(children.count) * sizeof(uint32_t)))
+        {
+            return;
+        }
+        // Pushed in reverse so they are read in file order. Marking them when queued guards against cycles and
+        // keeps nodes that several parents list from being queued more than once.
+        for (uint32_t i = children.count; i-- > 0;)
+        {
+            size_t child = reader.read<uint32_t>(children.offset + i * sizeof(uint32_t));
+            if (visited.insert(child).second)
+            {
+                pending.push_back({child, name});
+            }
+        }
+    }
+
+    // Growable model data block with offset-based writes, so earlier headers can be patched
+    class BinaryWriter
+    {
+    public:
+        size_t allocate(size_t length)
+        {
+            size_t offset = buffer.size();
+            buffer.resize(buffer.size() + length, 0);
+            return offset;
+        }
+
+        template <typename T>
+        void write(size_t offset, T value)
+        {
+            std::memcpy(buffer.data() + offset, &value, sizeof(T));
+        }
+
+        void writeString(size_t offset, const std::string& value, size_t length)
+        {
+            std::memcpy(buffer.data() + offset, value.data(), std::min(value.size(), length - 1));
+        }
+
+        void writeArrayDef(size_t offset, uint32_t arrayOffset, uint32_t count)
+        {
+            write<uint32_t>(offset, count > 0 ? arrayOffset : 0);
+            write<uint32_t>(offset + 4, count);
+            write<uint32_t>(offset + 8, count);
+        }
+
+        std::vector<unsigned char> buffer;
+    };
+
+    size_t writeNodeHeader(BinaryWriter& writer, size_t extraSize, const std::string& name, uint32_t partNumber,
+                           uint32_t parentOffset, uint32_t flags)
+    {
+        size_t offset = writer.allocate(NODE_HEADER_SIZE + extraSize);
+        writer.write<uint32_t>(offset + 28, partNumber);
+        writer.writeString(offset + 32, name, 32);
+        writer.write<uint32_t>(offset + 64, 0); // Geometry header
+        writer.write<uint32_t>(offset + 68, parentOffset);
+        writer.write<uint32_t>(offset + 108, flags);
+        return offset;
+    }
+
+    void writeEmitterHeader(BinaryWriter& writer, size_t offset, const EmitterNode& emitter)
+    {
+        writer.write<float>(offset + 0, emitter.deadspace);
+        writer.write<float>(offset + 4, emitter.blastRadius);
+        writer.write<float>(offset + 8, emitter.blastLength);
+        writer.write<uint32_t>(offset + 12, static_cast<uint32_t>(emitter.xgrid));
+        writer.write<uint32_t>(offset + 16, static_cast<uint32_t>(emitter.ygrid));
+        writer.write<uint32_t>(offset + 20, static_cast<uint32_t>(emitter.spawntype));
+        writer.writeString(offset + 24, std::string(updateTypeNames[static_cast<size_t>(emitter.update)]), 32);
+        writer.writeString(offset + 56, std::string(renderTypeNames[static_cast<size_t>(emitter.render)]), 32);
+        writer.writeString(offset + 88, std::string(blendTypeNames[static_cast<size_t>(emitter.blend)]), 32);
+        writer.writeString(offset + 120, emitter.texture.empty() ? "NULL" : emitter.texture, 64);
+        writer.writeString(offset + 184, "NULL", 16); // Chunk name
+        writer.write<uint32_t>(offset + 200, emitter.twosidedtex ? 1 : 0);
+        writer.write<uint32_t>(offset + 204, emitter.loop ? 1 : 0);
+        writer.write<uint16_t>(offset + 208, static_cast<uint16_t>(emitter.renderorder));
+
+        uint32_t flags = 0;
+        flags |= emitter.p2p ? EMITTER_P2P : 0;
+        flags |= emitter.p2p_sel == 1 ? EMITTER_P2P_BEZIER : 0;
+        flags |= emitter.affectedByWind ? EMITTER_AFFECTED_BY_WIND : 0;
+        flags |= emitter.m_isTinted ? EMITTER_TINTED : 0;
+        flags |= emitter.bounce ? EMITTER_BOUNCE : 0;
+        flags |= emitter.random ? EMITTER_RANDOM : 0;
+        flags |= emitter.inherit ? EMITTER_INHERIT : 0;
+        flags |= emitter.inheritvel ? EMITTER_INHERIT_VEL : 0;
+        flags |= emitter.inherit_local ? EMITTER_INHERIT_LOCAL : 0;
+        flags |= emitter.splat ? EMITTER_SPLAT : 0;
+        flags |= emitter.inherit_part ? EMITTER_INHERIT_PART : 0;
+        writer.write<uint32_t>(offset + 212, flags);
+    }
+
+    // One controller: a single row for static values, one row per key for animated tracks
+    struct ControllerTrack
+    {
+        uint32_t type;
+        int columns;
+        std::vector<float> times;
+        std::vector<float> values; // times.size() rows of columns values
+    };
+
+    void addPositionTrack(std::vector<ControllerTrack>& tracks, const glm::vec3& position, const AnimationTrack& keys)
+    {
+        ControllerTrack track{CONTROLLER_POSITION, 3, {}, {}};
+        if (keys.keyframes.empty())
+        {
+            track.times.push_back(0.0f);
+            track.values = {position.x, position.y, position.z};
+        }
+        for (const auto& key : keys.keyframes)
+        {
+            track.times.push_back(key.time);
+            track.values.insert(track.values.end(), {key.value.x, key.value.y, key.value.z});
+        }
+        tracks.push_back(std::move(track));
+    }
+
+    void addOrientationTrack(std::vector<ControllerTrack>& tracks, const glm::quat& orientation,
+                             const QuaternionTrack& keys)
+    {
+        ControllerTrack track{CONTROLLER_ORIENTATION, 4, {}, {}};
+        if (keys.keyframes.empty())
+        {
+            track.times.push_back(0.0f);
+            track.values = {orientation.x, orientation.y, orientation.z, orientation.w};
+        }
+        for (const auto& key : keys.keyframes)
+        {
+            track.times.push_back(key.time);
+            track.values.insert(track.values.end(), {key.value.x, key.value.y, key.value.z, key.value.w});
+        }
+        tracks.push_back(std::move(track));
+    }
+
+    void addEmitterTracks(std::vector<ControllerTrack>& tracks, const EmitterNode& emitter)
+    {
+        addPositionTrack(tracks, emitter.position, emitter.positionKeys);
+        addOrientationTrack(tracks, emitter.getOrientation(), emitter.orientationKeys);
+
+        for (const auto& controller : emitterControllers)
+        {
+            const EmitterField* field = findEmitterField(controller.field);
+            if (!field || isEmitterFieldOmitted(*field, emitter))
+                continue;
+
+            std::visit(
+                [&](auto member)
+                {
+                    const auto& value = emitter.*member;
+                    using T = std::remove_cvref_t<decltype(value)>;
+                    if constexpr (std::is_same_v<T, float>)
+                        tracks.push_back({controller.type, 1, {0.0f}, {value * field->scale}});
+                    else if constexpr (std::is_same_v<T, glm::vec3>)
+                        tracks.push_back({controller.type, 3, {0.0f}, {value.x, value.y, value.z}});
+                },
+                field->member);
+        }
+    }
+
+    // Returns false if the data no longer fits the 16-bit row and index fields
+    bool writeControllers(BinaryWriter& writer, size_t nodeOffset, const std::vector<ControllerTrack>& tracks)
+    {
+        // Each track is its key times followed by its rows of values
+        size_t floatCount = 0;
+        for (const auto& track : tracks)
+        {
+            if (track.times.size() > MAX_CONTROLLER_INDEX || floatCount + track.times.size() > MAX_CONTROLLER_INDEX)
+                return false;
+            floatCount += track.times.size() + track.values.size();
+        }
+
+        size_t keysOffset = writer.allocate(tracks.size() * CONTROLLER_KEY_SIZE);
+        size_t dataOffset = writer.allocate(floatCount * sizeof(float));
+
+        size_t dataIndex = 0;
+        for (size_t i = 0; i < tracks.size(); ++i)
+        {
+            const ControllerTrack& track = tracks[i];
+            size_t rows = track.times.size();
+            size_t keyOffset = keysOffset + i * CONTROLLER_KEY_SIZE;
+            writer.write<uint32_t>(keyOffset, track.type);
+            writer.write<uint16_t>(keyOffset + 4, static_cast<uint16_t>(rows));
+            writer.write<uint16_t>(keyOffset + 6, static_cast<uint16_t>(dataIndex));
+            writer.write<uint16_t>(keyOffset + 8, static_cast<uint16_t>(dataIndex + rows));
+            writer.write<uint8_t>(keyOffset + 10, static_cast<uint8_t>(track.columns));
+
+            for (size_t r = 0; r < rows; ++r)
+            {
+                writer.write<float>(dataOffset + (dataIndex + r) * sizeof(float), track.times[r]);
+            }
+            for (size_t v = 0; v < track.values.size(); ++v)
+            {
+                writer.write<float>(dataOffset + (dataIndex + rows + v) * sizeof(float), track.values[v]);
+            }
+            dataIndex += rows + track.values.size();
+        }
+
+        writer.writeArrayDef(nodeOffset + 84, static_cast<uint32_t>(keysOffset), static_cast<uint32_t>(tracks.size()));
+        writer.writeArrayDef(nodeOffset + 96, static_cast<uint32_t>(dataOffset), static_cast<uint32_t>(floatCount));
+        return true;
+    }
+} // namespace
+
+bool isBinaryMDL(const unsigned char* data, size_t size)
+{
+    return size >= FILE_HEADER_SIZE && data[0] == 0 && data[1] == 0 && data[2] == 0 && data[3] == 0;
+}
+
+bool readBinaryMDL(const unsigned char* data, size_t size, BinaryModel& model)
+{
+    if (!isBinaryMDL(data, size) || size < FILE_HEADER_SIZE + MODEL_HEADER_SIZE)
+    {
+        return false;
+    }
+
+    BinaryReader reader(data + FILE_HEADER_SIZE, size - FILE_HEADER_SIZE);
+    if (reader.read<uint8_t>(108) != GEOMETRY_TYPE_MODEL)
+    {
+        return false;
+    }
+
+    model = BinaryModel();
+    model.name = reader.readString(8, 64);
+    uint32_t rootNode = reader.read<uint32_t>(72);
+    if (readArrayDef(reader, 120).count > 0)
+    {
+        model.complete = false; // Animations are not read
+    }
+
+    std::unordered_set<size_t> visited = {rootNode};
+    std::vector<PendingNode> pending = {{rootNode, "NULL"}};
+    while (!pending.empty())
+    {
+        PendingNode node = std::move(pending.back());
+        pending.pop_back();
+        readNode(reader, node, model, pending, visited);
+    }
+    return true;
+}
+
+std::vector<unsigned char> writeBinaryMDL(const std::string& modelName, const std::vector<ModelNode>& dummies,
+                                          const std::vector<EmitterNode>& emitters)
+{
+    // Every node to write, the root first
+    struct Item
+    {
+        const std::string* name;
+        const std::string* parent;
+        const ModelNode* dummy;
+        const EmitterNode* emitter;
+    };
+
+    auto rootDummy =
+        std::find_if(dummies.begin(), dummies.end(), [](const ModelNode& node) { return node.parent == "NULL"; });
+    std::vector<Item> items;
+    items.push_back({&modelName, nullptr, rootDummy != dummies.end() ? &*rootDummy : nullptr, nullptr});
+    for (const auto& dummy : dummies)
+    {
+        if (&dummy != items[0].dummy)
+            items.push_back({&dummy.name, &dummy.parent, &dummy, nullptr});
+    }
+    for (const auto& emitter : emitters)
+    {
+        items.push_back({&emitter.name, &emitter.parent, nullptr, &emitter});
+    }
+
+    std::unordered_map<std::string, size_t> byName;
+    byName.emplace(modelName, 0);
+    if (items[0].dummy)
+        byName.emplace(items[0].dummy->name, 0);
+    for (size_t i = 1; i < items.size(); ++i)
+    {
+        byName.emplace(*items[i].name, i);
+    }
+
+    // Unknown parents and parent loops, which would never be reached from the root, hang off the root
+    std::vector<size_t> parents(items.size(), 0);
+    for (size_t i = 1; i < items.size(); ++i)
+    {
+        auto it = byName.find(*items[i].parent);
+        parents[i] = it != byName.end() && it->second != i ? it->second : 0;
+    }
+    for (size_t i = 1; i < items.size(); ++i)
+    {
+        size_t node = parents[i];
+        for (size_t steps = 0; node != 0 && steps < items.size(); ++steps)
+        {
+            node = parents[node];
+        }
+        if (node != 0)
+            parents[i] = 0;
+    }
+
+    BinaryWriter writer;
+
+    // Geometry and model header, function pointers are left zero as the engine fills them in at load time
+    size_t header = writer.allocate(MODEL_HEADER_SIZE);
+    writer.writeString(header + 8, modelName, 64);
+    writer.write<uint32_t>(header + 76, static_cast<uint32_t>(items.size()));
+    writer.write<uint8_t>(header + 108, GEOMETRY_TYPE_MODEL);
+    writer.write<uint8_t>(header + 114, CLASSIFICATION_EFFECT);
+    writer.write<uint8_t>(header + 115, 1); // Fogged
+    writer.write<float>(header + 164, 1.0f); // Animation scale
+    writer.writeString(header + 168, "NULL", 64); // Supermodel
+
+    std::vector<size_t> offsets(items.size());
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        const Item& item = items[i];
+        offsets[i] = writeNodeHeader(writer, item.emitter ? EMITTER_HEADER_SIZE : 0, *item.name,
+                                     static_cast<uint32_t>(i), 0, item.emitter ? NODE_TYPE_EMITTER : NODE_TYPE_DUMMY);
+
+        std::vector<ControllerTrack> tracks;
+        if (item.emitter)
+        {
+            writeEmitterHeader(writer, offsets[i] + NODE_HEADER_SIZE, *item.emitter);
+            addEmitterTracks(tracks, *item.emitter);
+        }
+        else if (item.dummy)
+        {
+            addPositionTrack(tracks, item.dummy->position, {});
+            addOrientationTrack(tracks, item.dummy->orientation, {});
+        }
+        if (!writeControllers(writer, offsets[i], tracks))
+            return {};
+    }
+    writer.write<uint32_t>(header + 72, static_cast<uint32_t>(offsets[0]));
+
+    // Parents may come after their children, so links are filled in once every node has its offset
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        std::vector<size_t> children;
+        for (size_t j = 1; j < items.size(); ++j)
+        {
+            if (parents[j] == i)
+                children.push_back(j);
+        }
+        if (i > 0)
+            writer.write<uint32_t>(offsets[i] + 68, static_cast<uint32_t>(offsets[parents[i]]));
+
+        size_t array = writer.allocate(children.size() * sizeof(uint32_t));
+        for (size_t c = 0; c < children.size(); ++c)
+        {
+            writer.write<uint32_t>(array + c * sizeof(uint32_t), static_cast<uint32_t>(offsets[children[c]]));
+        }
+        writer.writeArrayDef(offsets[i] + 72, static_cast<uint32_t>(array), static_cast<uint32_t>(children.size()));
+    }
+
+    // File header: binary marker, then the raw data block (vertex data, empty for emitters) after the model data
+    std::vector<unsigned char> file(FILE_HEADER_SIZE, 0);
+    uint32_t rawDataOffset = static_cast<uint32_t>(writer.buffer.size());
+    std::memcpy(file.data() + 4, &rawDataOffset, sizeof(rawDataOffset));
+    file.insert(file.end(), writer.buffer.begin(), writer.buffer.end());
+    return file;
+}
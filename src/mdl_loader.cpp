@@ -0,0 +1,148 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "mdl_loader.hpp"
+#include <algorithm>
+#include <filesystem>
+
+MDLLoader::MDLLoader() = default;
+
+MDLLoader::~MDLLoader()
+{
+    cancel();
+    join();
+}
+
+void MDLLoader::join()
+{
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+}
+
+void MDLLoader::start(const std::string& path)
+{
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(path, ec);
+    run(path, ec ? 0 : size, false,
+        [path](EmitterEditor& model, const MDLLoadObserver& observer) { return model.loadFromMDL(path, &observer); });
+}
+
+void MDLLoader::start(const std::string& name, const ResourceManager::Resource& resource)
+{
+    run(name, resource.size, true,
+        [name, resource](EmitterEditor& model, const MDLLoadObserver& observer)
+        { return model.loadFromMDL(name, resource.file, resource.data, resource.size, &observer); });
+}
+
+void MDLLoader::run(const std::string& name, uint64_t size, bool archive,
+                    std::function<bool(EmitterEditor&, const MDLLoadObserver&)> load)
+{
+    cancel();
+    join();
+
+    filename = name;
+    totalBytes = size;
+    fromArchive = archive;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        result.reset();
+        textureNames.clear();
+        status = Status::Loading;
+    }
+    cancelRequested.store(false, std::memory_order_relaxed);
+    bytesRead.store(0, std::memory_order_relaxed);
+    loading.store(true, std::memory_order_release);
+
+    worker = std::thread(
+        [this, load = std::move(load)]
+        {
+            auto model = std::make_unique<EmitterEditor>();
+
+            MDLLoadObserver observer;
+            observer.cancel = &cancelRequested;
+            observer.progress = [this](uint64_t bytes) { bytesRead.store(bytes, std::memory_order_relaxed); };
+            observer.textureFound = [this](const std::string& texture)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                textureNames.push_back(texture);
+            };
+
+            bool ok = load(*model, observer);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (cancelRequested.load(std::memory_order_relaxed))
+                {
+                    status = Status::Cancelled;
+                }
+                else if (ok)
+                {
+                    result = std::move(model);
+                    status = Status::Succeeded;
+                }
+                else
+                {
+                    status = Status::Failed;
+                }
+            }
+            loading.store(false, std::memory_order_release);
+        });
+}
+
+void MDLLoader::cancel() { cancelRequested.store(true, std::memory_order_relaxed); }
+
+float MDLLoader::getProgress() const
+{
+    if (totalBytes == 0)
+    {
+        return 0.0f;
+    }
+    return std::min(1.0f, static_cast<float>(bytesRead.load(std::memory_order_relaxed)) / totalBytes);
+}
+
+MDLLoader::Status MDLLoader::collect(EmitterEditor& target)
+{
+    if (isLoading())
+    {
+        return Status::Loading;
+    }
+
+    join();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Status finished = status;
+    if (finished == Status::Succeeded && result)
+    {
+        target = std::move(*result);
+        result.reset();
+    }
+    status = Status::Idle;
+    return finished;
+}
+
+std::vector<std::string> MDLLoader::takeTextureNames()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> names;
+    names.swap(textureNames);
+    return names;
+}
@@ -0,0 +1,283 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "mdl_text_view.hpp"
+#include <algorithm>
+#include <imgui.h>
+
+MDLTextView::MDLTextView() = default;
+
+MDLTextView::~MDLTextView() = default;
+
+void MDLTextView::rebuild(const EmitterEditor& editor)
+{
+    const std::string& next = editor.generateMDLText();
+    builtRevision = editor.getRevision();
+    if (lineOffsets.empty())
+    {
+        lineOffsets.push_back(0);
+    }
+
+    // Only the span between the unchanged head and tail is indexed again, an edit usually touches one emitter block
+    size_t prefix = std::mismatch(text.begin(), text.end(), next.begin(), next.end()).first - text.begin();
+    size_t common = std::min(text.size(), next.size()) - prefix;
+    size_t suffix = std::mismatch(text.rbegin(), text.rbegin() + common, next.rbegin()).first - text.rbegin();
+    if (prefix == text.size() && prefix == next.size())
+    {
+        return;
+    }
+    size_t oldEnd = text.size() - suffix;
+    size_t newEnd = next.size() - suffix;
+
+    // Lines starting past oldEnd follow an unchanged newline, they only move
+    int firstLine = static_cast<int>(std::upper_bound(lineOffsets.begin(), lineOffsets.end(), prefix) -
+                                     lineOffsets.begin()) - 1;
+    int tailLine = static_cast<int>(std::upper_bound(lineOffsets.begin(), lineOffsets.end(), oldEnd) -
+                                    lineOffsets.begin());
+    std::vector<size_t> changedOffsets;
+    for (size_t i = lineOffsets[firstLine]; i < newEnd; ++i)
+    {
+        if (next[i] == '\n' && i + 1 < next.size())
+        {
+            changedOffsets.push_back(i + 1);
+        }
+    }
+    for (size_t i = tailLine; i < lineOffsets.size(); ++i)
+    {
+        lineOffsets[i] = lineOffsets[i] - oldEnd + newEnd;
+    }
+    lineOffsets.erase(lineOffsets.begin() + firstLine + 1, lineOffsets.begin() + tailLine);
+    lineOffsets.insert(lineOffsets.begin() + firstLine + 1, changedOffsets.begin(), changedOffsets.end());
+    text.replace(prefix, oldEnd - prefix, next, prefix, newEnd - prefix);
+
+    int changedEnd = firstLine + 1 + static_cast<int>(changedOffsets.size());
+    int lineDelta = changedEnd - tailLine;
+
+    constexpr std::string_view emitterPrefix = "node emitter ";
+    std::erase_if(emitterLines, [&](const EmitterLine& emitterLine)
+    {
+        return emitterLine.line >= firstLine && emitterLine.line < tailLine;
+    });
+    std::vector<EmitterLine> changedEmitters;
+    for (int line = firstLine; line < changedEnd; ++line)
+    {
+        std::string_view lineText = getLine(line);
+        if (lineText.starts_with(emitterPrefix))
+        {
+            changedEmitters.push_back({std::string(lineText.substr(emitterPrefix.size())), line});
+        }
+    }
+    auto emitterInsert = std::find_if(emitterLines.begin(), emitterLines.end(), [&](const EmitterLine& emitterLine)
+    {
+        return emitterLine.line >= tailLine;
+    });
+    std::for_each(emitterInsert, emitterLines.end(), [&](EmitterLine& emitterLine)
+    {
+        emitterLine.line += lineDelta;
+    });
+    emitterLines.insert(emitterInsert, changedEmitters.begin(), changedEmitters.end());
+
+    // Same for the search, without scrolling away from what the user is looking at
+    if (!activeQuery.empty())
+    {
+        std::erase_if(matches, [&](int line) { return line >= firstLine && line < tailLine; });
+        std::vector<int> changedMatches;
+        for (int line = firstLine; line < changedEnd; ++line)
+        {
+            if (getLine(line).find(activeQuery) != std::string_view::npos)
+            {
+                changedMatches.push_back(line);
+            }
+        }
+        auto matchInsert = std::lower_bound(matches.begin(), matches.end(), tailLine);
+        std::for_each(matchInsert, matches.end(), [&](int& line) { line += lineDelta; });
+        matches.insert(matchInsert, changedMatches.begin(), changedMatches.end());
+    }
+    currentMatch = std::min(currentMatch, static_cast<int>(matches.size()) - 1);
+    highlightLine = currentMatch >= 0 ? matches[currentMatch] : -1;
+}
+
+std::string_view MDLTextView::getLine(int line) const
+{
+    size_t start = lineOffsets[line];
+    size_t end = line + 1 < static_cast<int>(lineOffsets.size()) ? lineOffsets[line + 1] : text.size();
+    if (end > start && text[end - 1] == '\n')
+    {
+        --end;
+    }
+    return std::string_view(text).substr(start, end - start);
+}
+
+void MDLTextView::findMatches(const std::string& query)
+{
+    if (query.empty())
+    {
+        matches.clear();
+    }
+    else if (!activeQuery.empty() && query.starts_with(activeQuery))
+    {
+        // Typing more characters can only narrow the result, so filter the previous matches
+        std::erase_if(matches, [&](int line) { return getLine(line).find(query) == std::string_view::npos; });
+    }
+    else
+    {
+        matches.clear();
+        for (int line = 0; line < static_cast<int>(lineOffsets.size()); ++line)
+        {
+            if (getLine(line).find(query) != std::string_view::npos)
+            {
+                matches.push_back(line);
+            }
+        }
+    }
+
+    activeQuery = query;
+}
+
+void MDLTextView::updateSearch()
+{
+    std::string query = searchBuffer;
+    if (query == activeQuery)
+    {
+        return;
+    }
+
+    findMatches(query);
+    currentMatch = -1;
+    highlightLine = -1;
+    jumpToMatch(1);
+}
+
+void MDLTextView::jumpToMatch(int direction)
+{
+    if (matches.empty())
+    {
+        return;
+    }
+
+    int count = static_cast<int>(matches.size());
+    currentMatch = currentMatch < 0 ? 0 : (currentMatch + direction + count) % count;
+    scrollToLine = matches[currentMatch];
+    highlightLine = scrollToLine;
+}
+
+void MDLTextView::render(const EmitterEditor& editor, bool* open)
+{
+    if (!ImGui::Begin("MDL Text View", open))
+    {
+        ImGui::End();
+        return;
+    }
+
+    if (builtRevision != editor.getRevision())
+    {
+        rebuild(editor);
+    }
+
+    if (ImGui::Button("Copy to Clipboard"))
+    {
+        ImGui::SetClipboardText(text.c_str());
+    }
+
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(200.0f);
+    const char* preview = "Jump to emitter...";
+    if (ImGui::BeginCombo("##JumpToEmitter", preview))
+    {
+        for (const auto& emitterLine : emitterLines)
+        {
+            if (ImGui::Selectable(emitterLine.name.c_str()))
+            {
+                scrollToLine = emitterLine.line;
+                highlightLine = emitterLine.line;
+            }
+        }
+        ImGui::EndCombo();
+    }
+
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(200.0f);
+    bool enterPressed = ImGui::InputTextWithHint("##Search", "Search", searchBuffer, sizeof(searchBuffer),
+                                                 ImGuiInputTextFlags_EnterReturnsTrue);
+    updateSearch();
+    if (enterPressed)
+    {
+        jumpToMatch(ImGui::GetIO().KeyShift ? -1 : 1);
+        ImGui::SetKeyboardFocusHere(-1); // Keep typing focus after Enter
+    }
+
+    ImGui::SameLine();
+    if (ImGui::ArrowButton("##PrevMatch", ImGuiDir_Up))
+    {
+        jumpToMatch(-1);
+    }
+    ImGui::SameLine();
+    if (ImGui::ArrowButton("##NextMatch", ImGuiDir_Down))
+    {
+        jumpToMatch(1);
+    }
+    ImGui::SameLine();
+    if (!activeQuery.empty())
+    {
+        ImGui::Text("%d/%zu", currentMatch + 1, matches.size());
+    }
+    else
+    {
+        ImGui::Text("%zu lines", lineOffsets.size());
+    }
+
+    ImGui::Separator();
+
+    ImGui::BeginChild("MDLTextLines", ImVec2(0, 0), ImGuiChildFlags_None, ImGuiWindowFlags_HorizontalScrollbar);
+
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(lineOffsets.size()));
+    if (scrollToLine >= 0 && scrollToLine < static_cast<int>(lineOffsets.size()))
+    {
+        clipper.IncludeItemByIndex(scrollToLine);
+    }
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    while (clipper.Step())
+    {
+        for (int line = clipper.DisplayStart; line < clipper.DisplayEnd; ++line)
+        {
+            std::string_view lineText = getLine(line);
+
+            if (line == highlightLine)
+            {
+                ImVec2 min = ImGui::GetCursorScreenPos();
+                ImVec2 max(min.x + ImGui::GetContentRegionAvail().x, min.y + ImGui::GetTextLineHeight());
+                drawList->AddRectFilled(min, max, ImGui::GetColorU32(ImGuiCol_TextSelectedBg));
+            }
+
+            ImGui::TextUnformatted(lineText.data(), lineText.data() + lineText.size());
+
+            if (line == scrollToLine)
+            {
+                ImGui::SetScrollHereY(0.25f);
+                scrollToLine = -1;
+            }
+        }
+    }
+    clipper.End();
+
+    ImGui::EndChild();
+    ImGui::End();
+}
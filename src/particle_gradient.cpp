@@ -0,0 +1,96 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "particle_gradient.hpp"
+
+namespace
+{
+    // Three-key curve; a negative mid value means the mid key is unused and start blends straight to end
+    template <typename T>
+    T evaluateKeys(const T& start, const T& mid, const T& end, bool hasMid, float t, float percentStart,
+                   float percentMid, float percentEnd)
+    {
+        if (t <= percentStart)
+            return start;
+        if (t >= percentEnd)
+            return end;
+
+        if (hasMid)
+        {
+            if (t < percentMid)
+            {
+                float span = percentMid - percentStart;
+                return span > 0.0f ? glm::mix(start, mid, (t - percentStart) / span) : mid;
+            }
+            float span = percentEnd - percentMid;
+            return span > 0.0f ? glm::mix(mid, end, (t - percentMid) / span) : end;
+        }
+
+        float span = percentEnd - percentStart;
+        return span > 0.0f ? glm::mix(start, end, (t - percentStart) / span) : end;
+    }
+} // namespace
+
+ParticleGradient::Keys ParticleGradient::keysOf(const EmitterNode& emitter)
+{
+    return {emitter.colorStart,   emitter.colorMid,   emitter.colorEnd,
+            emitter.alphaStart,   emitter.alphaMid,   emitter.alphaEnd,
+            emitter.sizeStart,    emitter.sizeMid,    emitter.sizeEnd,
+            emitter.sizeStart_y,  emitter.sizeMid_y,  emitter.sizeEnd_y,
+            emitter.percentStart, emitter.percentMid, emitter.percentEnd};
+}
+
+bool ParticleGradient::update(const EmitterNode& emitter)
+{
+    Keys current = keysOf(emitter);
+    if (baked && current == keys)
+        return false;
+
+    keys = current;
+    bake();
+    baked = true;
+    return true;
+}
+
+void ParticleGradient::bake()
+{
+    // Keep the key positions ordered so a hand-edited percentMid outside the range cannot fold the curve
+    float percentStart = glm::clamp(keys.percentStart, 0.0f, 1.0f);
+    float percentEnd = glm::clamp(keys.percentEnd, percentStart, 1.0f);
+    float percentMid = glm::clamp(keys.percentMid, percentStart, percentEnd);
+
+    bool hasColorMid = keys.colorMid.r >= 0.0f && keys.colorMid.g >= 0.0f && keys.colorMid.b >= 0.0f;
+
+    for (size_t i = 0; i < resolution; ++i)
+    {
+        float t = static_cast<float>(i) / static_cast<float>(resolution - 1);
+        Sample& sample = samples[i];
+
+        glm::vec3 color = evaluateKeys(keys.colorStart, keys.colorMid, keys.colorEnd, hasColorMid, t, percentStart,
+                                       percentMid, percentEnd);
+        float alpha = evaluateKeys(keys.alphaStart, keys.alphaMid, keys.alphaEnd, keys.alphaMid >= 0.0f, t,
+                                   percentStart, percentMid, percentEnd);
+        sample.color = glm::vec4(color, alpha);
+
+        sample.size.x = evaluateKeys(keys.sizeStart, keys.sizeMid, keys.sizeEnd, keys.sizeMid >= 0.0f, t,
+                                     percentStart, percentMid, percentEnd);
+        sample.size.y = evaluateKeys(keys.sizeStart_y, keys.sizeMid_y, keys.sizeEnd_y, keys.sizeMid_y >= 0.0f, t,
+                                     percentStart, percentMid, percentEnd);
+    }
+}
@@ -20,17 +20,25 @@
 #include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <glm/gtc/constants.hpp>
 #include <iostream>
 #include <limits>
 #include <unordered_map>
-#include "stb_dds.hpp"
+#include "emitter_fields.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARTICLE_SYSTEM_SSE2 1
+#endif
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
 
 // Vertex attribute layout constants
 constexpr int VERTEX_STRIDE = 14; // position(3) + texcoord(2) + color(4) + size(1) + velocity(3) + age(1)
 
+// Shader-only render modes after the MDL render types
+constexpr int RIBBON_RENDER_MODE = 7; // Lightning bolts
+constexpr int DECAL_RENDER_MODE = 8; // Splatted particles
+
 const char* vertexShaderCode = R"(
 #version 410 core
 
@@ -43,7 +51,7 @@ layout(location = 5) in float aAge;
 
 uniform mat4 view;
 uniform mat4 projection;
-uniform int renderMode; // 0=Normal, 1=Linked, 2=Billboard_Local_Z, 3=Billboard_World_Z, 4=Aligned_World_Z, 5=Aligned_Particle_Dir, 6=Motion_Blur
+uniform int renderMode; // 0=Normal, 1=Linked, 2=Billboard_Local_Z, 3=Billboard_World_Z, 4=Aligned_World_Z, 5=Aligned_Particle_Dir, 6=Motion_Blur, 7=Ribbon, 8=Decal
 uniform int xGrid;
 uniform int yGrid;
 uniform float fps;
@@ -103,12 +111,20 @@ void main() {
         vec3 billboardPos = aPos + (right * (aTexCoord.x - 0.5) * aSize + up * (aTexCoord.y - 0.5) * aSize * (1.0 + stretch));
         gl_Position = projection * view * vec4(billboardPos, 1.0);
     }
-    else if (renderMode == 1) { // Linked - similar to normal but particles will be connected
-        vec4 viewPos = view * worldPos;
-        right = vec3(view[0][0], view[1][0], view[2][0]);
-        up = vec3(view[0][1], view[1][1], view[2][1]);
-        vec3 billboardPos = viewPos.xyz + (right * (aTexCoord.x - 0.5) + up * (aTexCoord.y - 0.5)) * aSize;
-        gl_Position = projection * vec4(billboardPos, 1.0);
+    else if (renderMode == 7) { // Ribbon - segment from aPos along aVelocity, widened sideways to face the camera
+        vec3 cameraPos = -transpose(mat3(view)) * view[3].xyz;
+        vec3 side = cross(aVelocity, cameraPos - aPos);
+        side = length(side) > 0.0001 ? normalize(side) : vec3(view[0][0], view[1][0], view[2][0]);
+        vec3 ribbonPos = aPos + side * (aTexCoord.y - 0.5) * aSize;
+        gl_Position = projection * view * vec4(ribbonPos, 1.0);
+    }
+    else if (renderMode == 8) { // Decal - flat on the plane whose normal is passed in aVelocity
+        vec3 normal = normalize(aVelocity);
+        right = normalize(cross(normal, abs(normal.z) < 0.9 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0)));
+        up = cross(normal, right);
+        // Lifted slightly to avoid fighting with the grid
+        vec3 decalPos = aPos + normal * 0.01 + (right * (aTexCoord.x - 0.5) + up * (aTexCoord.y - 0.5)) * aSize;
+        gl_Position = projection * view * vec4(decalPos, 1.0);
     }
     else { // Default to Normal behavior
         vec4 viewPos = view * worldPos;
@@ -152,11 +168,16 @@ out vec4 FragColor;
 
 uniform sampler2D particleTexture;
 uniform bool hasTexture;
+uniform bool isStrip; // Bolts and ribbons, TexCoord.x runs along the whole strip
 
 void main() {
     vec4 texColor = vec4(1.0);
     if (hasTexture) {
         texColor = texture(particleTexture, TexCoord);
+    } else if (isStrip) {
+        // Soft edges across the strip only, so it stays visible end to end
+        float alpha = 1.0 - smoothstep(0.3, 0.5, abs(TexCoord.y - 0.5));
+        texColor = vec4(1.0, 1.0, 1.0, alpha);
     } else {
         // Create a simple circular gradient for untextured particles
         vec2 center = vec2(0.5, 0.5);
@@ -199,11 +220,43 @@ void main() {
 }
 )";
 
+// Linked particles as one triangle strip: two vertices per particle, expanded from the particle buffer by gl_VertexID
+const char* ribbonVertexShaderCode = R"(
+#version 410 core
+
+uniform samplerBuffer ribbonPoints; // Two texels per particle: position + size, color
+uniform int pointCount;
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec2 TexCoord;
+out vec4 Color;
+
+void main() {
+    int index = gl_VertexID / 2;
+    float side = float(gl_VertexID % 2) - 0.5;
+
+    vec4 point = texelFetch(ribbonPoints, index * 2);
+    vec3 previous = texelFetch(ribbonPoints, max(index - 1, 0) * 2).xyz;
+    vec3 next = texelFetch(ribbonPoints, min(index + 1, pointCount - 1) * 2).xyz;
+
+    // Widen across the chain, facing the camera
+    vec3 cameraPos = -transpose(mat3(view)) * view[3].xyz;
+    vec3 across = cross(next - previous, cameraPos - point.xyz);
+    across = length(across) > 0.0001 ? normalize(across) : vec3(view[0][0], view[1][0], view[2][0]);
+
+    gl_Position = projection * view * vec4(point.xyz + across * side * point.w, 1.0);
+    TexCoord = vec2(float(index) / float(max(pointCount - 1, 1)), side + 0.5);
+    Color = texelFetch(ribbonPoints, index * 2 + 1);
+}
+)";
+
 ParticleRenderer::ParticleRenderer() :
     shaderProgram(0), VAO(0), VBO(0), lineShaderProgram(0), lineVAO(0), lineVBO(0), framebuffer(0), colorTexture(0),
     depthBuffer(0), fbWidth(0), fbHeight(0), viewMatrix(1.0f), projectionMatrix(1.0f), globalAnimationTime(0.0f),
     vertexShaderSource(vertexShaderCode), fragmentShaderSource(fragmentShaderCode),
-    lineVertexShaderSource(lineVertexShaderCode), lineFragmentShaderSource(lineFragmentShaderCode)
+    lineVertexShaderSource(lineVertexShaderCode), lineFragmentShaderSource(lineFragmentShaderCode),
+    ribbonVertexShaderSource(ribbonVertexShaderCode)
 {
 }
 
@@ -213,8 +266,12 @@ void ParticleRenderer::initialize()
 {
     createShaders();
     createLineShaders();
+    createRibbonShaders();
     setupBuffers();
     setupLineBuffers();
+    setupRibbonBuffers();
+
+    textureStreamer.initialize();
 
     // Enable blending for particles
     glEnable(GL_BLEND);
@@ -231,6 +288,15 @@ void ParticleRenderer::cleanup()
 {
     cleanupFramebuffer();
 
+    for (auto& state : emitterStates)
+    {
+        if (state.gradientTexture)
+        {
+            glDeleteTextures(1, &state.gradientTexture);
+            state.gradientTexture = 0;
+        }
+    }
+
     if (shaderProgram)
     {
         glDeleteProgram(shaderProgram);
@@ -261,13 +327,28 @@ void ParticleRenderer::cleanup()
         glDeleteBuffers(1, &lineVBO);
         lineVBO = 0;
     }
-
-    for (GLuint texture : textures)
+    if (ribbonShaderProgram)
     {
-        glDeleteTextures(1, &texture);
+        glDeleteProgram(ribbonShaderProgram);
+        ribbonShaderProgram = 0;
     }
-    textures.clear();
-    textureCache.clear();
+    if (ribbonVAO)
+    {
+        glDeleteVertexArrays(1, &ribbonVAO);
+        ribbonVAO = 0;
+    }
+    if (ribbonBuffer)
+    {
+        glDeleteBuffers(1, &ribbonBuffer);
+        ribbonBuffer = 0;
+    }
+    if (ribbonTexture)
+    {
+        glDeleteTextures(1, &ribbonTexture);
+        ribbonTexture = 0;
+    }
+
+    textureStreamer.cleanup();
 }
 
 void ParticleRenderer::createShaders()
@@ -360,6 +441,42 @@ void ParticleRenderer::createLineShaders()
     glDeleteShader(fragmentShader);
 }
 
+void ParticleRenderer::createRibbonShaders()
+{
+    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertexShader, 1, &ribbonVertexShaderSource, nullptr);
+    glCompileShader(vertexShader);
+
+    GLint success;
+    GLchar infoLog[512];
+    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(vertexShader, 512, nullptr, infoLog);
+        std::cerr << "Ribbon vertex shader compilation failed: " << infoLog << std::endl;
+    }
+
+    // Ribbons share the particle fragment shader
+    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragmentShader, 1, &fragmentShaderSource, nullptr);
+    glCompileShader(fragmentShader);
+
+    ribbonShaderProgram = glCreateProgram();
+    glAttachShader(ribbonShaderProgram, vertexShader);
+    glAttachShader(ribbonShaderProgram, fragmentShader);
+    glLinkProgram(ribbonShaderProgram);
+
+    glGetProgramiv(ribbonShaderProgram, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glGetProgramInfoLog(ribbonShaderProgram, 512, nullptr, infoLog);
+        std::cerr << "Ribbon shader program linking failed: " << infoLog << std::endl;
+    }
+
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+}
+
 void ParticleRenderer::setupBuffers()
 {
     glGenVertexArrays(1, &VAO);
@@ -417,6 +534,23 @@ void ParticleRenderer::setupLineBuffers()
     glBindVertexArray(0);
 }
 
+void ParticleRenderer::setupRibbonBuffers()
+{
+    // The ribbon shader reads everything from the buffer texture, the VAO has no attributes
+    glGenVertexArrays(1, &ribbonVAO);
+
+    glGenBuffers(1, &ribbonBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, ribbonBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(float) * 8 * 1024, nullptr, GL_STREAM_DRAW);
+
+    glGenTextures(1, &ribbonTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, ribbonTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, ribbonBuffer);
+
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
 void ParticleRenderer::setCamera(const glm::mat4& view, const glm::mat4& projection)
 {
     viewMatrix = view;
@@ -426,6 +560,18 @@ void ParticleRenderer::setCamera(const glm::mat4& view, const glm::mat4& project
 void ParticleRenderer::render(const std::vector<EmitterNode>& emitters, float deltaTime, int viewportWidth,
                               int viewportHeight, int selectedEmitter)
 {
+    // Make textures that finished decoding resident, within this frame's upload budget
+    textureStreamer.update();
+
+    // Textures of the current emitters are pinned in the cache, everything else may be evicted
+    std::vector<std::string> textureNames;
+    textureNames.reserve(emitters.size());
+    for (const auto& emitter : emitters)
+    {
+        textureNames.push_back(getEmitterTextureName(emitter));
+    }
+    textureStreamer.setReferencedTextures(textureNames);
+
     // Resize state vector if needed
     while (emitterStates.size() < emitters.size())
     {
@@ -433,6 +579,8 @@ void ParticleRenderer::render(const std::vector<EmitterNode>& emitters, float de
     }
     while (emitterStates.size() > emitters.size())
     {
+        if (emitterStates.back().gradientTexture)
+            glDeleteTextures(1, &emitterStates.back().gradientTexture);
         emitterStates.pop_back();
     }
 
@@ -441,139 +589,392 @@ void ParticleRenderer::render(const std::vector<EmitterNode>& emitters, float de
     // Render grid first
     renderGrid();
 
-    // Render dummy node (root)
-    renderDummyNode(glm::vec3(0.0f));
+    // Resolve parent chains into world transforms, recomputing only what moved
+    sceneGraph.update(emitters, globalAnimationTime);
+
+    // Render dummy nodes, or the implicit root when the model has none
+    std::vector<glm::vec3> dummyPositions = sceneGraph.getDummyPositions();
+    if (dummyPositions.empty())
+    {
+        dummyPositions.push_back(glm::vec3(0.0f));
+    }
+    for (const auto& position : dummyPositions)
+    {
+        renderDummyNode(position);
+    }
 
     // Update and render each emitter
     for (size_t i = 0; i < emitters.size(); ++i)
     {
-        updateParticles(emitters[i], emitterStates[i], deltaTime);
-        renderParticles(emitters[i], emitterStates[i]);
+        updateParticles(emitters[i], emitterStates[i], sceneGraph.getEmitterWorld(i), deltaTime);
+        if (emitters[i].render == RenderType::Linked)
+            renderRibbon(emitters[i], emitterStates[i]);
+        else
+            renderParticles(emitters[i], emitterStates[i]);
     }
 
     // Render emitter nodes
     renderNodes(emitters, selectedEmitter);
+
+    textureStreamer.endFrame();
 }
 
-void ParticleRenderer::updateParticles(const EmitterNode& emitter, ParticleSystemState& state, float deltaTime)
+void ParticleRenderer::updateParticles(const EmitterNode& emitter, ParticleSystemState& state, const glm::mat4& world,
+                                       float deltaTime)
 {
     // Update animation time
     state.animationTime += deltaTime;
+
+    // Rebaked only when the emitter's color, alpha or size keys changed
+    if (state.gradient.update(emitter))
+    {
+        uploadGradientTexture(state);
+    }
+
+    // Colliding emitters hand their moving particles to the batch as they are integrated
+    bool collides = emitter.bounce || emitter.splat;
+
     // Update existing particles
-    for (auto& particle : state.particles)
+    for (uint32_t i = 0; i < state.particles.size(); ++i)
     {
-        if (particle.active)
+        Particle& particle = state.particles[i];
+        particle.life -= deltaTime;
+        if (particle.life <= 0.0f)
         {
-            particle.life -= deltaTime;
-            if (particle.life <= 0.0f)
-            {
-                particle.active = false;
-                continue;
-            }
+            particle.active = false;
+            continue;
+        }
+
+        // Update color and size from the baked gradient
+        const ParticleGradient::Sample& sample = state.gradient.sample(1.0f - particle.life / particle.maxLife);
+        particle.color = sample.color;
+        particle.size = sample.size.x;
 
-            // Update position
-            particle.position += particle.velocity * deltaTime;
+        // Splats stay where they landed
+        if (particle.splatted)
+            continue;
+
+        // Update position
+        particle.position += particle.velocity * deltaTime;
 
-            // Apply gravity (in Z-up coordinate system, gravity points down in -Z)
-            particle.velocity.z -= emitter.grav * deltaTime;
+        // Apply gravity (in Z-up coordinate system, gravity points down in -Z)
+        particle.velocity.z -= emitter.grav * deltaTime;
 
-            // Apply drag
-            particle.velocity *= (1.0f - emitter.drag * deltaTime);
+        // Apply drag
+        particle.velocity *= (1.0f - emitter.drag * deltaTime);
 
-            // Update color and size based on life percentage
-            float lifePercent = particle.life / particle.maxLife;
-            particle.color = glm::vec4(glm::mix(emitter.colorEnd, emitter.colorStart, lifePercent),
-                                       glm::mix(emitter.alphaEnd, emitter.alphaStart, lifePercent));
-            particle.size = glm::mix(emitter.sizeEnd, emitter.sizeStart, lifePercent);
+        // Apply rotation
+        particle.rotation += emitter.particleRot * deltaTime;
 
-            // Apply rotation
-            particle.rotation += emitter.particleRot * deltaTime;
+        if (collides)
+        {
+            collisionBatch.push(i, particle);
+            if (collisionBatch.full())
+                collideParticles(emitter, state, deltaTime);
         }
     }
 
-    // Spawn new particles for fountain emitters
+    if (collides)
+    {
+        collideParticles(emitter, state, deltaTime);
+    }
+
+    // Keep the pool packed in spawn order so new particles are always appended at the end
+    std::erase_if(state.particles, [](const Particle& particle) { return !particle.active; });
+
+    if (emitter.update != UpdateType::Lightning)
+    {
+        state.boltPoints.clear();
+    }
+
     if (emitter.update == UpdateType::Fountain && emitter.birthrate > 0.0f)
     {
+        // Continuous emission, everything due this frame is spawned together
         float spawnInterval = 1.0f / emitter.birthrate;
         state.lastSpawnTime += deltaTime;
 
-        while (state.lastSpawnTime >= spawnInterval && state.particles.size() < state.maxParticles)
+        auto due = static_cast<size_t>(state.lastSpawnTime / spawnInterval);
+        state.lastSpawnTime -= static_cast<float>(due) * spawnInterval;
+        spawnParticles(emitter, state, world, due);
+    }
+    else if (emitter.update == UpdateType::Lightning)
+    {
+        updateLightning(emitter, state, world, deltaTime);
+    }
+    else if (emitter.update == UpdateType::Explosion || emitter.update == UpdateType::Single)
+    {
+        // Looping bursts re-arm once the previous burst has died out
+        if (emitter.loop && state.particles.empty())
+        {
+            state.burstPending = true;
+        }
+
+        if (state.burstPending)
         {
-            // Use animated position if available
-            glm::vec3 emitterPos = emitter.getAnimatedPosition(state.animationTime);
-            spawnParticle(emitter, state, emitterPos);
-            state.lastSpawnTime -= spawnInterval;
+            // Explosions release birthrate particles at once, single emitters one particle
+            size_t count = emitter.update == UpdateType::Single
+                               ? 1
+                               : static_cast<size_t>(std::max(emitter.birthrate, 0.0f));
+            spawnParticles(emitter, state, world, count);
+            state.burstPending = false;
         }
     }
 }
 
-void ParticleRenderer::spawnParticle(const EmitterNode& emitter, ParticleSystemState& state,
-                                     const glm::vec3& emitterPos)
+// Collides the gathered block and writes it back to the pool, leaving the batch empty
+void ParticleRenderer::collideParticles(const EmitterNode& emitter, ParticleSystemState& state, float deltaTime)
 {
-    // Find inactive particle or add new one
-    Particle* particle = nullptr;
-    for (auto& p : state.particles)
+    // The ground plane Z=0 always collides, user planes are added on top
+    const glm::vec4 groundPlane(0.0f, 0.0f, 1.0f, 0.0f);
+
+    collisionBatch.collide(groundPlane, emitter.bounce_co, deltaTime, emitter.splat);
+    for (const auto& plane : collisionPlanes)
     {
-        if (!p.active)
-        {
-            particle = &p;
-            break;
-        }
+        collisionBatch.collide(plane, emitter.bounce_co, deltaTime, emitter.splat);
     }
+    collisionBatch.scatter(state.particles);
+}
 
-    if (!particle && state.particles.size() < state.maxParticles)
+void ParticleRenderer::CollisionBatch::push(uint32_t index, const Particle& particle)
+{
+    // Splats never move, so everything pushed is still in flight
+    particles[count] = index;
+    for (int c = 0; c < 3; ++c)
     {
-        state.particles.emplace_back();
-        particle = &state.particles.back();
+        position[c][count] = particle.position[c];
+        velocity[c][count] = particle.velocity[c];
     }
+    splatted[count] = 0.0f;
+    ++count;
+}
 
-    if (!particle)
-        return; // No available particle slots
-
-    // Initialize particle
-    particle->active = true;
-    particle->life = emitter.lifeExp;
-    particle->maxLife = emitter.lifeExp;
-    particle->mass = emitter.mass;
-
-    // Random position within emitter bounds (in local space)
-    std::uniform_real_distribution<float> xDist(-emitter.xsize / 2.0f, emitter.xsize / 2.0f);
-    std::uniform_real_distribution<float> yDist(-emitter.ysize / 2.0f, emitter.ysize / 2.0f);
+void ParticleRenderer::CollisionBatch::collide(const glm::vec4& plane, float restitution, float deltaTime, bool splat)
+{
+    float* px = position[0].data();
+    float* py = position[1].data();
+    float* pz = position[2].data();
+    float* vx = velocity[0].data();
+    float* vy = velocity[1].data();
+    float* vz = velocity[2].data();
+    float* sx = splatNormal[0].data();
+    float* sy = splatNormal[1].data();
+    float* sz = splatNormal[2].data();
+    float* landed = splatted.data();
+    const float scale = 1.0f + restitution;
+    size_t i = 0;
+
+#ifdef PARTICLE_SYSTEM_SSE2
+    // Four particles per iteration, same arithmetic as the scalar loop below
+    const __m128 nx = _mm_set1_ps(plane.x), ny = _mm_set1_ps(plane.y), nz = _mm_set1_ps(plane.z);
+    const __m128 offset = _mm_set1_ps(plane.w);
+    const __m128 step = _mm_set1_ps(deltaTime);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(px + i), y = _mm_loadu_ps(py + i), z = _mm_loadu_ps(pz + i);
+        __m128 u = _mm_loadu_ps(vx + i), v = _mm_loadu_ps(vy + i), w = _mm_loadu_ps(vz + i);
+        __m128 wasSplatted = _mm_loadu_ps(landed + i);
+
+        __m128 distance = _mm_add_ps(
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, x), _mm_mul_ps(ny, y)), _mm_mul_ps(nz, z)), offset);
+        __m128 normalSpeed = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, u), _mm_mul_ps(ny, v)), _mm_mul_ps(nz, w));
+        __m128 previousDistance = _mm_sub_ps(distance, _mm_mul_ps(normalSpeed, step));
+        __m128 crossed = _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(distance, zero), _mm_cmpge_ps(previousDistance, zero)),
+                                    _mm_cmpeq_ps(wasSplatted, zero));
+        __m128 hit = _mm_and_ps(crossed, one);
+
+        if (splat)
+        {
+            // Stick to the plane and turn into a decal
+            __m128 depth = _mm_mul_ps(distance, hit);
+            __m128 keep = _mm_sub_ps(one, hit);
+            _mm_storeu_ps(px + i, _mm_sub_ps(x, _mm_mul_ps(nx, depth)));
+            _mm_storeu_ps(py + i, _mm_sub_ps(y, _mm_mul_ps(ny, depth)));
+            _mm_storeu_ps(pz + i, _mm_sub_ps(z, _mm_mul_ps(nz, depth)));
+            _mm_storeu_ps(vx + i, _mm_mul_ps(u, keep));
+            _mm_storeu_ps(vy + i, _mm_mul_ps(v, keep));
+            _mm_storeu_ps(vz + i, _mm_mul_ps(w, keep));
+            _mm_storeu_ps(sx + i, _mm_or_ps(_mm_and_ps(crossed, nx), _mm_andnot_ps(crossed, _mm_loadu_ps(sx + i))));
+            _mm_storeu_ps(sy + i, _mm_or_ps(_mm_and_ps(crossed, ny), _mm_andnot_ps(crossed, _mm_loadu_ps(sy + i))));
+            _mm_storeu_ps(sz + i, _mm_or_ps(_mm_and_ps(crossed, nz), _mm_andnot_ps(crossed, _mm_loadu_ps(sz + i))));
+            _mm_storeu_ps(landed + i, _mm_max_ps(wasSplatted, hit));
+        }
+        else
+        {
+            // Reflect position and velocity, losing energy by bounce_co
+            __m128 bounce = _mm_mul_ps(_mm_set1_ps(scale), hit);
+            __m128 depth = _mm_mul_ps(distance, bounce);
+            __m128 speed = _mm_mul_ps(normalSpeed, bounce);
+            _mm_storeu_ps(px + i, _mm_sub_ps(x, _mm_mul_ps(nx, depth)));
+            _mm_storeu_ps(py + i, _mm_sub_ps(y, _mm_mul_ps(ny, depth)));
+            _mm_storeu_ps(pz + i, _mm_sub_ps(z, _mm_mul_ps(nz, depth)));
+            _mm_storeu_ps(vx + i, _mm_sub_ps(u, _mm_mul_ps(nx, speed)));
+            _mm_storeu_ps(vy + i, _mm_sub_ps(v, _mm_mul_ps(ny, speed)));
+            _mm_storeu_ps(vz + i, _mm_sub_ps(w, _mm_mul_ps(nz, speed)));
+        }
+    }
+#endif
 
-    glm::vec3 localPos = glm::vec3(xDist(state.rng), yDist(state.rng), 0.0f);
+    // Only particles that crossed from the front to the back of the plane this frame are hit.
+    // hit is 0 or 1 and scales every correction, so the loop has no data-dependent branches.
+    for (; i < count; ++i)
+    {
+        float distance = plane.x * px[i] + plane.y * py[i] + plane.z * pz[i] + plane.w;
+        float normalSpeed = plane.x * vx[i] + plane.y * vy[i] + plane.z * vz[i];
+        float previousDistance = distance - normalSpeed * deltaTime;
+        bool crossed = (distance < 0.0f) & (previousDistance >= 0.0f) & (landed[i] == 0.0f);
+        float hit = static_cast<float>(crossed);
 
-    // Transform local position by emitter orientation
-    glm::mat3 rotMatrix = glm::mat3_cast(emitter.getOrientation());
-    particle->position = emitterPos + rotMatrix * localPos;
+        if (splat)
+        {
+            float depth = distance * hit;
+            float keep = 1.0f - hit;
+            px[i] -= plane.x * depth;
+            py[i] -= plane.y * depth;
+            pz[i] -= plane.z * depth;
+            vx[i] *= keep;
+            vy[i] *= keep;
+            vz[i] *= keep;
+            sx[i] = crossed ? plane.x : sx[i];
+            sy[i] = crossed ? plane.y : sy[i];
+            sz[i] = crossed ? plane.z : sz[i];
+            landed[i] = std::max(landed[i], hit);
+        }
+        else
+        {
+            float bounce = scale * hit;
+            float depth = distance * bounce;
+            float speed = normalSpeed * bounce;
+            px[i] -= plane.x * depth;
+            py[i] -= plane.y * depth;
+            pz[i] -= plane.z * depth;
+            vx[i] -= plane.x * speed;
+            vy[i] -= plane.y * speed;
+            vz[i] -= plane.z * speed;
+        }
+    }
+}
 
-    // Random velocity direction within 3D cone spread (in local space)
-    std::uniform_real_distribution<float> spreadDist(0.0f, emitter.spread / 2.0f);
-    std::uniform_real_distribution<float> azimuthDist(0.0f, 360.0f);
-    std::uniform_real_distribution<float> velocityVar(0.8f, 1.2f);
+void ParticleRenderer::CollisionBatch::scatter(std::vector<Particle>& pool)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        Particle& particle = pool[particles[i]];
+        particle.position = glm::vec3(position[0][i], position[1][i], position[2][i]);
+        particle.velocity = glm::vec3(velocity[0][i], velocity[1][i], velocity[2][i]);
+        if (splatted[i] != 0.0f)
+        {
+            particle.splatNormal = glm::vec3(splatNormal[0][i], splatNormal[1][i], splatNormal[2][i]);
+            particle.splatted = true;
+        }
+    }
+    count = 0;
+}
 
-    float spreadAngle = glm::radians(spreadDist(state.rng)); // Cone angle from center
-    float azimuth = glm::radians(azimuthDist(state.rng)); // Random rotation around cone axis
-    float speed = emitter.velocity * velocityVar(state.rng);
+void ParticleRenderer::updateLightning(const EmitterNode& emitter, ParticleSystemState& state, const glm::mat4& world,
+                                       float deltaTime)
+{
+    // The bolt runs lightningRadius along the local Z axis
+    constexpr float defaultBoltLength = 5.0f;
+    float length = emitter.lightningRadius > 0.0f ? emitter.lightningRadius : defaultBoltLength;
+    LightningParams params{static_cast<int>(emitter.lightningZigZag), static_cast<int>(emitter.lightningSubDiv),
+                           emitter.lightningScale};
+
+    // Without a delay the bolt still flickers, at a fixed rate instead of every frame
+    constexpr float defaultInterval = 1.0f / 15.0f;
+    float interval = emitter.lightningDelay > 0.0f ? emitter.lightningDelay : defaultInterval;
+
+    state.boltTimer += deltaTime;
+    if (state.boltLocal.empty() || state.boltTimer >= interval || length != state.boltLength ||
+        params != state.boltParams)
+    {
+        generateLightningBolt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, length), params, state.rng, state.boltLocal);
+        state.boltLength = length;
+        state.boltParams = params;
+        state.boltTimer = 0.0f;
+    }
 
-    // Generate velocity in 3D cone around Z-axis
-    float x = sin(spreadAngle) * cos(azimuth) * speed;
-    float y = sin(spreadAngle) * sin(azimuth) * speed;
-    float z = cos(spreadAngle) * speed;
+    // Moving or rotating the emitter only transforms the cached bolt
+    state.boltPoints.resize(state.boltLocal.size());
+    for (size_t i = 0; i < state.boltLocal.size(); ++i)
+    {
+        state.boltPoints[i] = glm::vec3(world * glm::vec4(state.boltLocal[i], 1.0f));
+    }
+}
 
-    glm::vec3 localVelocity = glm::vec3(x, y, z);
+void ParticleRenderer::spawnParticles(const EmitterNode& emitter, ParticleSystemState& state, const glm::mat4& world,
+                                      size_t count)
+{
+    // Reserve all new slots at the end of the pool in one step
+    size_t first = state.particles.size();
+    count = std::min(count, state.maxParticles - std::min(first, state.maxParticles));
+    if (count == 0)
+        return;
+    state.particles.resize(first + count);
 
-    // Transform velocity by emitter orientation
-    particle->velocity = rotMatrix * localVelocity;
+    // Draw the random numbers first so the initialization loop below is free of RNG state
+    std::uniform_real_distribution<float> xDist(-emitter.xsize / 2.0f, emitter.xsize / 2.0f);
+    std::uniform_real_distribution<float> yDist(-emitter.ysize / 2.0f, emitter.ysize / 2.0f);
+    std::uniform_real_distribution<float> spreadDist(0.0f, glm::radians(emitter.spread / 2.0f));
+    std::uniform_real_distribution<float> azimuthDist(0.0f, glm::two_pi<float>());
+    std::uniform_real_distribution<float> velocityVar(0.8f, 1.2f);
 
-    // Initial color and size
-    particle->color = glm::vec4(emitter.colorStart, emitter.alphaStart);
-    particle->size = emitter.sizeStart;
-    particle->rotation = 0.0f;
+    state.spawnRandoms.resize(count);
+    for (auto& random : state.spawnRandoms)
+    {
+        random.x = xDist(state.rng);
+        random.y = yDist(state.rng);
+        random.spread = spreadDist(state.rng); // Cone angle from center
+        random.azimuth = azimuthDist(state.rng); // Random rotation around cone axis
+        random.speed = emitter.velocity * velocityVar(state.rng);
+    }
+
+    // Local space is transformed into world space through the emitter's parent chain
+    glm::mat3 rotMatrix = glm::mat3(world);
+    glm::vec3 origin = glm::vec3(world[3]);
+    const ParticleGradient::Sample& birth = state.gradient.sample(0.0f);
+
+    // Trail emitters spread the batch along the path moved since the last spawn, so fast motion leaves no gaps
+    glm::vec3 previousOrigin =
+        emitter.spawntype == SpawnType::Trail && state.hasSpawnOrigin ? state.lastSpawnOrigin : origin;
+    state.lastSpawnOrigin = origin;
+    state.hasSpawnOrigin = true;
+
+    Particle* particles = state.particles.data() + first;
+    const ParticleSystemState::SpawnRandom* randoms = state.spawnRandoms.data();
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto& random = randoms[i];
+        Particle& particle = particles[i];
+
+        particle.active = true;
+        particle.splatted = false;
+        particle.life = emitter.lifeExp;
+        particle.maxLife = emitter.lifeExp;
+        particle.mass = emitter.mass;
+
+        // Random position within emitter bounds
+        float along = static_cast<float>(i + 1) / static_cast<float>(count);
+        particle.position = glm::mix(previousOrigin, origin, along) + rotMatrix * glm::vec3(random.x, random.y, 0.0f);
+
+        // Velocity in a 3D cone around the local Z axis
+        float sinSpread = std::sin(random.spread);
+        glm::vec3 localVelocity = glm::vec3(sinSpread * std::cos(random.azimuth), sinSpread * std::sin(random.azimuth),
+                                            std::cos(random.spread)) *
+                                  random.speed;
+        particle.velocity = rotMatrix * localVelocity;
+
+        // Initial color and size
+        particle.color = birth.color;
+        particle.size = birth.size.x;
+        particle.rotation = 0.0f;
+    }
 }
 
 void ParticleRenderer::renderParticles(const EmitterNode& emitter, const ParticleSystemState& state)
 {
-    if (state.particles.empty())
+    if (state.particles.empty() && state.boltPoints.empty())
         return;
 
     // Save current blend state
@@ -588,9 +989,12 @@ void ParticleRenderer::renderParticles(const EmitterNode& emitter, const Particl
     GLint projLoc = glGetUniformLocation(shaderProgram, "projection");
     GLint hasTextureLoc = glGetUniformLocation(shaderProgram, "hasTexture");
     GLint renderModeLoc = glGetUniformLocation(shaderProgram, "renderMode");
+    GLint isStripLoc = glGetUniformLocation(shaderProgram, "isStrip");
 
     glUniformMatrix4fv(viewLoc, 1, GL_FALSE, &viewMatrix[0][0]);
     glUniformMatrix4fv(projLoc, 1, GL_FALSE, &projectionMatrix[0][0]);
+    // Particles keep the emitter's render type, also those left over after switching it to Lightning.
+    // Each later batch sets its own mode.
     glUniform1i(renderModeLoc, static_cast<int>(emitter.render));
 
     // Set texture atlas uniforms
@@ -601,18 +1005,100 @@ void ParticleRenderer::renderParticles(const EmitterNode& emitter, const Particl
     glUniform1f(glGetUniformLocation(shaderProgram, "frameEnd"),
                 emitter.frameEnd > 0 ? emitter.frameEnd : emitter.xgrid * emitter.ygrid - 1);
 
+    glUniform1i(hasTextureLoc, bindParticleTexture(emitter, shaderProgram) ? 1 : 0);
+    glUniform1i(isStripLoc, 0);
+    applyParticleBlend(emitter);
+
+    // Prepare vertex data
+    std::vector<float> vertexData;
+
+    // Quad vertices for each particle - positions are relative to particle center.
+    // Vertex layout: position(3) + texcoord(2) + color(4) + size(1) + velocity(3) + age(1)
+    auto appendParticle = [&vertexData](const Particle& particle, const glm::vec3& direction)
+    {
+        constexpr float corners[6][2] = {{0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, // Triangle 1
+                                         {0.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f}}; // Triangle 2
+        float age = particle.getAge();
+        for (const auto& corner : corners)
+        {
+            vertexData.insert(vertexData.end(),
+                              {particle.position.x, particle.position.y, particle.position.z, corner[0], corner[1],
+                               particle.color.r, particle.color.g, particle.color.b, particle.color.a, particle.size,
+                               direction.x, direction.y, direction.z, age});
+        }
+    };
+
+    for (const auto& particle : state.particles)
+    {
+        if (particle.active && !particle.splatted)
+            appendParticle(particle, particle.velocity);
+    }
+
+    size_t billboardVertices = vertexData.size() / VERTEX_STRIDE;
+
+    appendBoltVertices(state, vertexData);
+    size_t boltVertices = vertexData.size() / VERTEX_STRIDE - billboardVertices;
+
+    // Splats lie flat on the plane they hit, the decal mode reads its normal from the velocity slot
+    for (const auto& particle : state.particles)
+    {
+        if (particle.active && particle.splatted)
+            appendParticle(particle, particle.splatNormal);
+    }
+    size_t splatVertices = vertexData.size() / VERTEX_STRIDE - billboardVertices - boltVertices;
+
+    if (vertexData.empty())
+        return;
+
+    // Upload and draw
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, vertexData.size() * sizeof(float), vertexData.data());
+
+    glDepthMask(GL_FALSE); // Disable depth writing for particles
+    if (billboardVertices > 0)
+    {
+        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(billboardVertices));
+    }
+    if (boltVertices > 0)
+    {
+        glUniform1i(renderModeLoc, RIBBON_RENDER_MODE);
+        glUniform1i(isStripLoc, 1);
+        glDrawArrays(GL_TRIANGLES, static_cast<GLint>(billboardVertices), static_cast<GLsizei>(boltVertices));
+        glUniform1i(isStripLoc, 0);
+    }
+    if (splatVertices > 0)
+    {
+        glUniform1i(renderModeLoc, DECAL_RENDER_MODE);
+        glDrawArrays(GL_TRIANGLES, static_cast<GLint>(billboardVertices + boltVertices),
+                     static_cast<GLsizei>(splatVertices));
+    }
+    glDepthMask(GL_TRUE); // Re-enable for other objects
+
+    glBindVertexArray(0);
+    glUseProgram(0);
+
+    // Restore original blend state for editor elements
+    glBlendFunc(srcBlend, dstBlend);
+}
+
+bool ParticleRenderer::bindParticleTexture(const EmitterNode& emitter, GLuint program)
+{
     // Bind texture if available
-    GLuint texture = getTexture(emitter.texturePath.empty() ? emitter.texture : emitter.texturePath);
+    GLuint texture = textureStreamer.get(getEmitterTextureName(emitter));
     bool hasTexture = (texture != 0 && (!emitter.texturePath.empty() || !emitter.texture.empty()));
-    glUniform1i(hasTextureLoc, hasTexture ? 1 : 0);
 
     if (hasTexture)
     {
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, texture);
-        glUniform1i(glGetUniformLocation(shaderProgram, "particleTexture"), 0);
+        glUniform1i(glGetUniformLocation(program, "particleTexture"), 0);
     }
+    return hasTexture;
+}
 
+void ParticleRenderer::applyParticleBlend(const EmitterNode& emitter)
+{
     // Set blend mode specific to particles
     switch (emitter.blend)
     {
@@ -626,176 +1112,129 @@ void ParticleRenderer::renderParticles(const EmitterNode& emitter, const Particl
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         break;
     }
+}
 
-    // Prepare vertex data
-    std::vector<float> vertexData;
+void ParticleRenderer::renderRibbon(const EmitterNode& emitter, const ParticleSystemState& state)
+{
+    // Consecutive particles in the pool are consecutive along the chain, oldest first
+    if (state.particles.size() < 2)
+        return;
 
+    ribbonPoints.clear();
+    ribbonPoints.reserve(state.particles.size() * 8);
     for (const auto& particle : state.particles)
     {
-        if (!particle.active)
-            continue;
-
-        // Create quad vertices for each particle - positions are relative to particle center
-        // Vertex layout: position(3) + texcoord(2) + color(4) + size(1) + velocity(3) + age(1)
-        float age = particle.getAge();
-
-        // Triangle 1
-        vertexData.insert(vertexData.end(),
-                          {
-                              particle.position.x, particle.position.y, particle.position.z, // center pos
-                              0.0f, 0.0f, // texcoord
-                              particle.color.r, particle.color.g, particle.color.b, particle.color.a, // color
-                              particle.size, // size
-                              particle.velocity.x, particle.velocity.y, particle.velocity.z, // velocity
-                              age // particle age
-                          });
-        vertexData.insert(vertexData.end(),
-                          {particle.position.x, particle.position.y, particle.position.z, 1.0f, 0.0f, particle.color.r,
-                           particle.color.g, particle.color.b, particle.color.a, particle.size, particle.velocity.x,
-                           particle.velocity.y, particle.velocity.z, age});
-        vertexData.insert(vertexData.end(),
-                          {particle.position.x, particle.position.y, particle.position.z, 1.0f, 1.0f, particle.color.r,
-                           particle.color.g, particle.color.b, particle.color.a, particle.size, particle.velocity.x,
-                           particle.velocity.y, particle.velocity.z, age});
-
-        // Triangle 2
-        vertexData.insert(vertexData.end(),
-                          {particle.position.x, particle.position.y, particle.position.z, 0.0f, 0.0f, particle.color.r,
-                           particle.color.g, particle.color.b, particle.color.a, particle.size, particle.velocity.x,
-                           particle.velocity.y, particle.velocity.z, age});
-        vertexData.insert(vertexData.end(),
-                          {particle.position.x, particle.position.y, particle.position.z, 1.0f, 1.0f, particle.color.r,
-                           particle.color.g, particle.color.b, particle.color.a, particle.size, particle.velocity.x,
-                           particle.velocity.y, particle.velocity.z, age});
-        vertexData.insert(vertexData.end(),
-                          {particle.position.x, particle.position.y, particle.position.z, 0.0f, 1.0f, particle.color.r,
-                           particle.color.g, particle.color.b, particle.color.a, particle.size, particle.velocity.x,
-                           particle.velocity.y, particle.velocity.z, age});
+        ribbonPoints.insert(ribbonPoints.end(),
+                            {particle.position.x, particle.position.y, particle.position.z, particle.size,
+                             particle.color.r, particle.color.g, particle.color.b, particle.color.a});
     }
 
-    if (vertexData.empty())
-        return;
-
-    // Upload and draw
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, vertexData.size() * sizeof(float), vertexData.data());
-
-    glDepthMask(GL_FALSE); // Disable depth writing for particles
-    glDrawArrays(GL_TRIANGLES, 0, vertexData.size() / VERTEX_STRIDE);
-    glDepthMask(GL_TRUE); // Re-enable for other objects
+    GLint srcBlend, dstBlend;
+    glGetIntegerv(GL_BLEND_SRC_ALPHA, &srcBlend);
+    glGetIntegerv(GL_BLEND_DST_ALPHA, &dstBlend);
 
+    glUseProgram(ribbonShaderProgram);
+    glUniformMatrix4fv(glGetUniformLocation(ribbonShaderProgram, "view"), 1, GL_FALSE, &viewMatrix[0][0]);
+    glUniformMatrix4fv(glGetUniformLocation(ribbonShaderProgram, "projection"), 1, GL_FALSE, &projectionMatrix[0][0]);
+    glUniform1i(glGetUniformLocation(ribbonShaderProgram, "pointCount"), static_cast<GLint>(state.particles.size()));
+    glUniform1i(glGetUniformLocation(ribbonShaderProgram, "hasTexture"),
+                bindParticleTexture(emitter, ribbonShaderProgram) ? 1 : 0);
+    glUniform1i(glGetUniformLocation(ribbonShaderProgram, "isStrip"), 1);
+    applyParticleBlend(emitter);
+
+    // Orphan the buffer each frame so the upload never waits on the previous draw
+    glBindBuffer(GL_TEXTURE_BUFFER, ribbonBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, ribbonPoints.size() * sizeof(float), ribbonPoints.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_BUFFER, ribbonTexture);
+    glUniform1i(glGetUniformLocation(ribbonShaderProgram, "ribbonPoints"), 1);
+
+    glBindVertexArray(ribbonVAO);
+    glDepthMask(GL_FALSE);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, static_cast<GLsizei>(state.particles.size() * 2));
+    glDepthMask(GL_TRUE);
     glBindVertexArray(0);
+
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE0);
     glUseProgram(0);
 
-    // Restore original blend state for editor elements
     glBlendFunc(srcBlend, dstBlend);
 }
 
-void ParticleRenderer::loadTexture(const std::string& textureNameOrPath)
+void ParticleRenderer::appendBoltVertices(const ParticleSystemState& state, std::vector<float>& vertexData) const
 {
-    if (textureNameOrPath.empty())
+    if (state.boltPoints.size() < 2)
         return;
-    if (textureCache.find(textureNameOrPath) != textureCache.end())
-        return;
-
-    unsigned char* data = nullptr;
-    int width, height, channels;
-    std::string texturePath;
 
-    stbi_set_flip_vertically_on_load(true);
+    // One quad per segment, drawn after the particles with the ribbon render mode
+    const ParticleGradient::Sample& look = state.gradient.sample(0.0f);
+    const glm::vec4& color = look.color;
+    float width = look.size.x;
+    float segments = static_cast<float>(state.boltPoints.size() - 1);
 
-    // Check if it's a full path or just a name
-    if (textureNameOrPath.find('/') != std::string::npos || textureNameOrPath.find('\\') != std::string::npos)
+    for (size_t i = 0; i + 1 < state.boltPoints.size(); ++i)
     {
-        // It's a full path, try loading directly
-        texturePath = textureNameOrPath;
+        const glm::vec3& a = state.boltPoints[i];
+        const glm::vec3& b = state.boltPoints[i + 1];
+        glm::vec3 direction = b - a;
+        float u0 = static_cast<float>(i) / segments;
+        float u1 = static_cast<float>(i + 1) / segments;
 
-        if (texturePath.ends_with(".dds"))
+        auto vertex = [&](const glm::vec3& position, float u, float v)
         {
-            data = stbi_load_dds(texturePath.c_str(), &width, &height, &channels, 0);
-        }
-        else
-        {
-            data = stbi_load(texturePath.c_str(), &width, &height, &channels, 0);
-        }
+            vertexData.insert(vertexData.end(), {position.x, position.y, position.z, u, v, color.r, color.g, color.b,
+                                                 color.a, width, direction.x, direction.y, direction.z, 0.0f});
+        };
+        vertex(a, u0, 0.0f);
+        vertex(b, u1, 0.0f);
+        vertex(b, u1, 1.0f);
+        vertex(a, u0, 0.0f);
+        vertex(b, u1, 1.0f);
+        vertex(a, u0, 1.0f);
     }
-    else
-    {
-        // It's just a name, try multiple extensions in texture directory
-        std::vector<std::string> extensions = {".dds", ".tga", ".png", ".jpg"};
-
-        for (const auto& ext : extensions)
-        {
-            texturePath = textureDirectory + "/" + textureNameOrPath + ext;
-
-            if (ext == ".dds")
-            {
-                data = stbi_load_dds(texturePath.c_str(), &width, &height, &channels, 0);
-            }
-            else
-            {
-                data = stbi_load(texturePath.c_str(), &width, &height, &channels, 0);
-            }
+}
 
-            if (data)
-            {
-                break; // Successfully loaded
-            }
-        }
+void ParticleRenderer::uploadGradientTexture(ParticleSystemState& state)
+{
+    const auto& samples = state.gradient.getSamples();
+    std::vector<float> texels;
+    texels.reserve(samples.size() * 4);
+    for (const auto& sample : samples)
+    {
+        texels.insert(texels.end(), {sample.color.r, sample.color.g, sample.color.b, sample.color.a});
     }
 
-    GLuint texture = 0;
-    if (data)
+    if (!state.gradientTexture)
     {
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-
-        GLenum format = GL_RGB;
-        if (channels == 4)
-            format = GL_RGBA;
-        else if (channels == 1)
-            format = GL_RED;
-
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glGenTextures(1, &state.gradientTexture);
+        glBindTexture(GL_TEXTURE_2D, state.gradientTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        // Free memory - both stb_image and stb_dds use malloc
-        stbi_image_free(data);
-
-        textures.push_back(texture);
-        textureCache[textureNameOrPath] = texture;
-
-        std::cout << "Loaded texture: " << texturePath << " (" << width << "x" << height << ")" << std::endl;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, static_cast<GLsizei>(samples.size()), 1, 0, GL_RGBA, GL_FLOAT,
+                     texels.data());
     }
     else
     {
-        std::cerr << "Failed to load texture: " << textureNameOrPath << " (tried .dds, .tga, .png, .jpg extensions)"
-                  << std::endl;
-        textureCache[textureNameOrPath] = 0;
+        glBindTexture(GL_TEXTURE_2D, state.gradientTexture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, static_cast<GLsizei>(samples.size()), 1, GL_RGBA, GL_FLOAT,
+                        texels.data());
     }
+    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-void ParticleRenderer::setTextureDirectory(const std::string& directory) { textureDirectory = directory; }
-
-GLuint ParticleRenderer::getTexture(const std::string& textureNameOrPath)
+const std::string& ParticleRenderer::getEmitterTextureName(const EmitterNode& emitter)
 {
-    if (textureNameOrPath.empty())
-        return 0;
-
-    auto it = textureCache.find(textureNameOrPath);
-    if (it == textureCache.end())
-    {
-        loadTexture(textureNameOrPath);
-        it = textureCache.find(textureNameOrPath);
-    }
+    return emitter.texturePath.empty() ? emitter.texture : emitter.texturePath;
+}
 
-    return (it != textureCache.end()) ? it->second : 0;
+void ParticleRenderer::setTextureDirectory(const std::string& directory)
+{
+    textureStreamer.setTextureDirectory(directory);
 }
 
 void ParticleRenderer::renderNodes(const std::vector<EmitterNode>& emitters, int selectedEmitter)
@@ -806,7 +1245,7 @@ void ParticleRenderer::renderNodes(const std::vector<EmitterNode>& emitters, int
     for (int i = 0; i < static_cast<int>(emitters.size()); ++i)
     {
         bool isSelected = (i == selectedEmitter);
-        renderEmitterNode(emitters[i], isSelected);
+        renderEmitterNode(emitters[i], sceneGraph.getEmitterWorld(i), isSelected);
     }
 }
 
@@ -851,7 +1290,7 @@ void ParticleRenderer::renderDummyNode(const glm::vec3& position)
     glUseProgram(0);
 }
 
-void ParticleRenderer::renderEmitterNode(const EmitterNode& emitter, bool isSelected)
+void ParticleRenderer::renderEmitterNode(const EmitterNode& emitter, const glm::mat4& world, bool isSelected)
 {
     // Ensure standard blend state for editor elements
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -867,11 +1306,8 @@ void ParticleRenderer::renderEmitterNode(const EmitterNode& emitter, bool isSele
     glUniformMatrix4fv(viewLoc, 1, GL_FALSE, &viewMatrix[0][0]);
     glUniformMatrix4fv(projLoc, 1, GL_FALSE, &projectionMatrix[0][0]);
 
-    // Apply both animated translation and rotation
-    glm::vec3 animatedPos = emitter.getAnimatedPosition(globalAnimationTime);
-    glm::mat4 model = glm::translate(glm::mat4(1.0f), animatedPos);
-    model = model * glm::mat4_cast(emitter.getOrientation());
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, &model[0][0]);
+    // Cached world transform, includes animation and parent nodes
+    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, &world[0][0]);
 
     // Color based on selection state
     if (isSelected)
@@ -920,8 +1356,8 @@ void ParticleRenderer::renderEmitterNode(const EmitterNode& emitter, bool isSele
         // Spread indicators (cone around Z-axis)
         if (emitter.spread > 0.0f)
         {
-            float spreadX = sin(spreadRad) * arrowLength;
-            float spreadZ = cos(spreadRad) * arrowLength;
+            float spreadX = std::sin(spreadRad) * arrowLength;
+            float spreadZ = std::cos(spreadRad) * arrowLength;
 
             // Four spread lines forming a cone
             emitterVertices.insert(emitterVertices.end(),
@@ -1363,6 +1799,132 @@ void ParticleRenderer::renderToTexture(const std::vector<EmitterNode>& emitters,
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+glm::vec3 ParticleRenderer::getEmitterWorldPosition(int emitterIndex) const
+{
+    if (emitterIndex < 0 || emitterIndex >= static_cast<int>(sceneGraph.getEmitterCount()))
+        return glm::vec3(0.0f);
+    return sceneGraph.getEmitterWorldPosition(emitterIndex);
+}
+
+glm::vec3 ParticleRenderer::worldToParentOffset(int emitterIndex, const glm::vec3& offset) const
+{
+    if (emitterIndex < 0 || emitterIndex >= static_cast<int>(sceneGraph.getEmitterCount()))
+        return offset;
+    glm::mat3 parent = glm::mat3(sceneGraph.getEmitterParentWorld(emitterIndex));
+    if (std::abs(glm::determinant(parent)) < 1e-8f)
+        return offset; // Parent scaled to nothing, any offset is as good as another
+    return glm::inverse(parent) * offset;
+}
+
+glm::vec3 ParticleRenderer::rotateInWorld(int emitterIndex, const glm::vec3& rotation, const glm::vec3& delta) const
+{
+    if (delta == glm::vec3(0.0f))
+        return rotation;
+
+    glm::quat parent(1.0f, 0.0f, 0.0f, 0.0f);
+    if (emitterIndex >= 0 && emitterIndex < static_cast<int>(sceneGraph.getEmitterCount()))
+    {
+        glm::mat3 parentWorld = glm::mat3(sceneGraph.getEmitterParentWorld(emitterIndex));
+        if (std::abs(glm::determinant(parentWorld)) >= 1e-8f)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                parentWorld[axis] = glm::normalize(parentWorld[axis]);
+            }
+            parent = glm::quat_cast(parentWorld);
+        }
+    }
+
+    // Conjugating by the parent rotation expresses the world delta in the parent's frame, where it applies on top
+    // of the emitter's own orientation
+    glm::quat worldDelta(glm::radians(delta));
+    glm::quat local = glm::normalize(glm::inverse(parent) * worldDelta * parent * glm::quat(glm::radians(rotation)));
+    glm::vec3 angles = glm::degrees(glm::eulerAngles(local));
+
+    // Of the two Euler triples for the orientation, keep the one closest to the old angles, each wrapped to the
+    // nearest turn, so the fields do not jump while dragging
+    auto unwrap = [&](glm::vec3 candidate)
+    {
+        candidate += 360.0f * glm::round((rotation - candidate) / 360.0f);
+        return candidate;
+    };
+    glm::vec3 first = unwrap(angles);
+    glm::vec3 second = unwrap(glm::vec3(angles.x + 180.0f, 180.0f - angles.y, angles.z + 180.0f));
+    glm::vec3 firstDistance = glm::abs(first - rotation);
+    glm::vec3 secondDistance = glm::abs(second - rotation);
+    return firstDistance.x + firstDistance.y + firstDistance.z <= secondDistance.x + secondDistance.y + secondDistance.z
+               ? first
+               : second;
+}
+
+GLuint ParticleRenderer::getGradientTexture(int emitterIndex) const
+{
+    if (emitterIndex < 0 || emitterIndex >= static_cast<int>(emitterStates.size()))
+        return 0;
+    return emitterStates[emitterIndex].gradientTexture;
+}
+
+int ParticleRenderer::reloadEmitters(const std::vector<EmitterNode>& previous, const std::vector<EmitterNode>& current)
+{
+    // Unrendered emitters have no state yet, they start fresh either way.
+    // Indices are stored last to first so emitters sharing a name pair up in file order.
+    std::unordered_map<std::string, std::vector<size_t>> previousByName;
+    for (size_t i = std::min(previous.size(), emitterStates.size()); i-- > 0;)
+    {
+        previousByName[previous[i].name].push_back(i);
+    }
+
+    std::vector<ParticleSystemState> states(current.size());
+    int reset = 0;
+    for (size_t i = 0; i < current.size(); ++i)
+    {
+        auto it = previousByName.find(current[i].name);
+        if (it == previousByName.end() || it->second.empty())
+        {
+            ++reset;
+            continue;
+        }
+
+        size_t match = it->second.back();
+        it->second.pop_back();
+        if (!diffEmitterFields(previous[match], current[i]).empty())
+        {
+            ++reset;
+            continue;
+        }
+        states[i] = std::move(emitterStates[match]);
+        emitterStates[match].gradientTexture = 0;
+    }
+
+    for (auto& state : emitterStates)
+    {
+        if (state.gradientTexture)
+            glDeleteTextures(1, &state.gradientTexture);
+    }
+    emitterStates = std::move(states);
+    return reset;
+}
+
+void ParticleRenderer::setCollisionPlanes(const std::vector<glm::vec4>& planes)
+{
+    collisionPlanes.clear();
+    for (const auto& plane : planes)
+    {
+        // Normalize so the plane offset is a distance, skip degenerate normals
+        float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f)
+            collisionPlanes.push_back(plane / length);
+    }
+}
+
+void ParticleRenderer::retrigger()
+{
+    for (auto& state : emitterStates)
+    {
+        state.burstPending = true;
+    }
+}
+
 int ParticleRenderer::getActiveParticleCount(int emitterIndex) const
 {
     if (emitterIndex < 0 || emitterIndex >= static_cast<int>(emitterStates.size()))
@@ -1458,8 +2020,8 @@ bool ParticleRenderer::rayIntersectsCone(const Ray& ray, const glm::vec3& apex,
     // Simplified cone intersection - treat as expanding sphere along direction
     // This is a reasonable approximation for picking purposes
 
-    float cosAngle = cos(angle);
-    float sinAngle = sin(angle);
+    float cosAngle = std::cos(angle);
+    float sinAngle = std::sin(angle);
 
     // Check multiple points along the cone axis for intersection
     const int samples = 10;
@@ -1491,10 +2053,14 @@ int ParticleRenderer::pickEmitter(const std::vector<EmitterNode>& emitters, floa
     int closestEmitter = -1;
     float closestDistance = std::numeric_limits<float>::max();
 
+    // Transforms are cached by render(), nothing to pick before the first frame
+    if (sceneGraph.getEmitterCount() != emitters.size())
+        return closestEmitter;
+
     for (int i = 0; i < static_cast<int>(emitters.size()); ++i)
     {
         const EmitterNode& emitter = emitters[i];
-        glm::vec3 emitterPos = emitter.getAnimatedPosition(globalAnimationTime);
+        glm::vec3 emitterPos = sceneGraph.getEmitterWorldPosition(i);
         float distance;
 
         // Check intersection with emitter node (as a sphere)
@@ -1511,8 +2077,8 @@ int ParticleRenderer::pickEmitter(const std::vector<EmitterNode>& emitters, floa
         // Check intersection with spread cone (if velocity > 0 and spread > 0)
         if (emitter.velocity > 0.0f && emitter.spread > 0.0f)
         {
-            // Transform cone direction by emitter orientation
-            glm::mat3 rotMatrix = glm::mat3_cast(emitter.getOrientation());
+            // Transform cone direction by the emitter's world orientation
+            glm::mat3 rotMatrix = sceneGraph.getEmitterWorldRotation(i);
             glm::vec3 coneDirection = rotMatrix * glm::vec3(0.0f, 0.0f, 1.0f); // Local Z-axis
 
             float coneHeight = 2.0f; // Visible length of cone
@@ -1865,8 +2431,8 @@ void ParticleRenderer::renderRotationModeIndicator(int viewportWidth, int viewpo
             float angle1 = 2.0f * M_PI * i / numSegments;
             float angle2 = 2.0f * M_PI * (i + 1) / numSegments;
             indicatorVertices.insert(indicatorVertices.end(),
-                                     {circleRadius * cos(angle1), circleRadius * sin(angle1), 0.0f,
-                                      circleRadius * cos(angle2), circleRadius * sin(angle2), 0.0f});
+                                     {circleRadius * std::cos(angle1), circleRadius * std::sin(angle1), 0.0f,
+                                      circleRadius * std::cos(angle2), circleRadius * std::sin(angle2), 0.0f});
         }
         glBufferSubData(GL_ARRAY_BUFFER, 0, indicatorVertices.size() * sizeof(float), indicatorVertices.data());
         glDrawArrays(GL_LINES, 0, numSegments * 2);
@@ -1879,8 +2445,8 @@ void ParticleRenderer::renderRotationModeIndicator(int viewportWidth, int viewpo
             float angle1 = 2.0f * M_PI * i / numSegments;
             float angle2 = 2.0f * M_PI * (i + 1) / numSegments;
             indicatorVertices.insert(indicatorVertices.end(),
-                                     {circleRadius * cos(angle1), 0.0f, circleRadius * sin(angle1),
-                                      circleRadius * cos(angle2), 0.0f, circleRadius * sin(angle2)});
+                                     {circleRadius * std::cos(angle1), 0.0f, circleRadius * std::sin(angle1),
+                                      circleRadius * std::cos(angle2), 0.0f, circleRadius * std::sin(angle2)});
         }
         glBufferSubData(GL_ARRAY_BUFFER, 0, indicatorVertices.size() * sizeof(float), indicatorVertices.data());
         glDrawArrays(GL_LINES, 0, numSegments * 2);
@@ -1893,8 +2459,8 @@ void ParticleRenderer::renderRotationModeIndicator(int viewportWidth, int viewpo
             float angle1 = 2.0f * M_PI * i / numSegments;
             float angle2 = 2.0f * M_PI * (i + 1) / numSegments;
             indicatorVertices.insert(indicatorVertices.end(),
-                                     {0.0f, circleRadius * cos(angle1), circleRadius * sin(angle1), 0.0f,
-                                      circleRadius * cos(angle2), circleRadius * sin(angle2)});
+                                     {0.0f, circleRadius * std::cos(angle1), circleRadius * std::sin(angle1), 0.0f,
+                                      circleRadius * std::cos(angle2), circleRadius * std::sin(angle2)});
         }
         glBufferSubData(GL_ARRAY_BUFFER, 0, indicatorVertices.size() * sizeof(float), indicatorVertices.data());
         glDrawArrays(GL_LINES, 0, numSegments * 2);
@@ -1909,8 +2475,8 @@ void ParticleRenderer::renderRotationModeIndicator(int viewportWidth, int viewpo
             float angle1 = 2.0f * M_PI * i / numSegments;
             float angle2 = 2.0f * M_PI * (i + 1) / numSegments;
             indicatorVertices.insert(indicatorVertices.end(),
-                                     {0.0f, circleRadius * cos(angle1), circleRadius * sin(angle1), 0.0f,
-                                      circleRadius * cos(angle2), circleRadius * sin(angle2)});
+                                     {0.0f, circleRadius * std::cos(angle1), circleRadius * std::sin(angle1), 0.0f,
+                                      circleRadius * std::cos(angle2), circleRadius * std::sin(angle2)});
         }
         glBufferSubData(GL_ARRAY_BUFFER, 0, indicatorVertices.size() * sizeof(float), indicatorVertices.data());
         glDrawArrays(GL_LINES, 0, numSegments * 2);
@@ -1925,8 +2491,8 @@ void ParticleRenderer::renderRotationModeIndicator(int viewportWidth, int viewpo
             float angle1 = 2.0f * M_PI * i / numSegments;
             float angle2 = 2.0f * M_PI * (i + 1) / numSegments;
             indicatorVertices.insert(indicatorVertices.end(),
-                                     {circleRadius * cos(angle1), 0.0f, circleRadius * sin(angle1),
-                                      circleRadius * cos(angle2), 0.0f, circleRadius * sin(angle2)});
+                                     {circleRadius * std::cos(angle1), 0.0f, circleRadius * std::sin(angle1),
+                                      circleRadius * std::cos(angle2), 0.0f, circleRadius * std::sin(angle2)});
         }
         glBufferSubData(GL_ARRAY_BUFFER, 0, indicatorVertices.size() * sizeof(float), indicatorVertices.data());
         glDrawArrays(GL_LINES, 0, numSegments * 2);
@@ -1941,8 +2507,8 @@ void ParticleRenderer::renderRotationModeIndicator(int viewportWidth, int viewpo
             float angle1 = 2.0f * M_PI * i / numSegments;
             float angle2 = 2.0f * M_PI * (i + 1) / numSegments;
             indicatorVertices.insert(indicatorVertices.end(),
-                                     {circleRadius * cos(angle1), circleRadius * sin(angle1), 0.0f,
-                                      circleRadius * cos(angle2), circleRadius * sin(angle2), 0.0f});
+                                     {circleRadius * std::cos(angle1), circleRadius * std::sin(angle1), 0.0f,
+                                      circleRadius * std::cos(angle2), circleRadius * std::sin(angle2), 0.0f});
         }
         glBufferSubData(GL_ARRAY_BUFFER, 0, indicatorVertices.size() * sizeof(float), indicatorVertices.data());
         glDrawArrays(GL_LINES, 0, numSegments * 2);
@@ -18,6 +18,7 @@
 
 #include "property_editor.hpp"
 #include <algorithm>
+#include <cfloat>
 #include <cstring>
 #include <filesystem>
 #include <glm/gtc/quaternion.hpp>
@@ -39,7 +40,7 @@ void PropertyEditor::render(EmitterEditor& editor, int& selectedEmitter)
     auto& emitters = editor.getEmitters();
     if (selectedEmitter >= 0 && selectedEmitter < static_cast<int>(emitters.size()))
     {
-        renderEmitterProperties(emitters[selectedEmitter]);
+        renderEmitterProperties(editor, selectedEmitter);
     }
     else
     {
@@ -74,6 +75,47 @@ void PropertyEditor::renderOutliner(EmitterEditor& editor, int& selectedEmitter)
         propertiesChanged = true;
     }
 
+    const auto& animations = editor.getAnimations();
+    if (!animations.empty())
+    {
+        // Animations are only parsed once picked here
+        int selectedAnimation = editor.getSelectedAnimation();
+        const char* preview = selectedAnimation >= 0 ? animations[selectedAnimation].name.c_str() : "(none)";
+        if (ImGui::BeginCombo("Animation", preview))
+        {
+            if (ImGui::Selectable("(none)", selectedAnimation < 0))
+            {
+                editor.selectAnimation(-1);
+            }
+            for (int i = 0; i < static_cast<int>(animations.size()); ++i)
+            {
+                if (ImGui::Selectable(animations[i].name.c_str(), i == selectedAnimation))
+                {
+                    editor.selectAnimation(i);
+                }
+            }
+            ImGui::EndCombo();
+        }
+    }
+
+    // Keys can also come with the geometry, without any animation
+    bool hasKeys = std::any_of(emitters.begin(), emitters.end(),
+                               [](const EmitterNode& emitter)
+                               {
+                                   return !emitter.positionKeys.keyframes.empty() ||
+                                       !emitter.orientationKeys.keyframes.empty();
+                               });
+    if (!animations.empty() || hasKeys)
+    {
+        bool bake = editor.getBakeLongTracks();
+        if (ImGui::Checkbox("Bake Long Tracks", &bake))
+        {
+            editor.setBakeLongTracks(bake);
+        }
+        ImGui::SetItemTooltip("Resample tracks of %zu or more keys for faster playback, smoothing out fine detail",
+                              EmitterEditor::bakeKeyThreshold);
+    }
+
     ImGui::Separator();
 
     // List emitters
@@ -90,8 +132,13 @@ void PropertyEditor::renderOutliner(EmitterEditor& editor, int& selectedEmitter)
 }
 
 
-void PropertyEditor::renderEmitterProperties(EmitterNode& emitter)
+void PropertyEditor::renderEmitterProperties(EmitterEditor& editor, int index)
 {
+    EmitterNode& emitter = editor.getEmitters()[index];
+
+    // Track edits made by this emitter's widgets separately so only it gets re-serialized
+    bool changedBefore = propertiesChanged;
+    propertiesChanged = false;
     ImGui::Text("Emitter: %s", emitter.name.c_str());
 
     if (ImGui::CollapsingHeader("Basic Properties", ImGuiTreeNodeFlags_DefaultOpen))
@@ -104,12 +151,12 @@ void PropertyEditor::renderEmitterProperties(EmitterNode& emitter)
             if (newName.empty() || newName.find_first_not_of(" \t\n\r") == std::string::npos)
             {
                 // Empty or whitespace-only name, use default
-                emitter.name = "default_emitter";
+                editor.renameEmitter(index, "default_emitter");
                 ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "Warning: Empty name replaced with default");
             }
             else
             {
-                emitter.name = newName;
+                editor.renameEmitter(index, newName);
             }
             propertiesChanged = true;
         }
@@ -140,7 +187,7 @@ void PropertyEditor::renderEmitterProperties(EmitterNode& emitter)
 
         // Texture selection dialog
         static std::string selectedTexturePath;
-        if (FileDialog::renderTextureDialog("Select Texture", selectedTexturePath))
+        if (FileDialog::renderTextureDialog("Select Texture", selectedTexturePath, textureIndex))
         {
             emitter.texturePath = selectedTexturePath;
             emitter.texture = std::filesystem::path(selectedTexturePath).stem().string();
@@ -207,22 +254,44 @@ void PropertyEditor::renderEmitterProperties(EmitterNode& emitter)
     {
         if (renderColorEdit("Color Start", emitter.colorStart))
             propertiesChanged = true;
+        glm::vec3 colorBetween = glm::mix(emitter.colorStart, emitter.colorEnd, 0.5f);
+        if (renderOptionalColorEdit("Color Mid", emitter.colorMid, colorBetween))
+            propertiesChanged = true;
         if (renderColorEdit("Color End", emitter.colorEnd))
             propertiesChanged = true;
         if (renderEditableFloat("Alpha Start", emitter.alphaStart, 0.01f, 0.0f, 1.0f))
             propertiesChanged = true;
+        if (renderOptionalFloat("Alpha Mid", emitter.alphaMid, (emitter.alphaStart + emitter.alphaEnd) * 0.5f, 0.01f))
+            propertiesChanged = true;
         if (renderEditableFloat("Alpha End", emitter.alphaEnd, 0.01f, 0.0f, 1.0f))
             propertiesChanged = true;
+
+        if (renderEditableFloat("Percent Start", emitter.percentStart, 0.01f, 0.0f, 1.0f))
+            propertiesChanged = true;
+        if (renderEditableFloat("Percent Mid", emitter.percentMid, 0.01f, 0.0f, 1.0f))
+            propertiesChanged = true;
+        if (renderEditableFloat("Percent End", emitter.percentEnd, 0.01f, 0.0f, 1.0f))
+            propertiesChanged = true;
+
+        if (gradientTexture)
+        {
+            ImGui::Image(gradientTexture, ImVec2(ImGui::GetContentRegionAvail().x, 12.0f));
+        }
     }
 
     if (ImGui::CollapsingHeader("Size"))
     {
         if (renderEditableFloat("Size Start", emitter.sizeStart, 0.1f))
             propertiesChanged = true;
+        if (renderOptionalFloat("Size Mid", emitter.sizeMid, (emitter.sizeStart + emitter.sizeEnd) * 0.5f, 0.1f))
+            propertiesChanged = true;
         if (renderEditableFloat("Size End", emitter.sizeEnd, 0.1f))
             propertiesChanged = true;
         if (renderEditableFloat("Size Start Y", emitter.sizeStart_y, 0.1f))
             propertiesChanged = true;
+        if (renderOptionalFloat("Size Mid Y", emitter.sizeMid_y, (emitter.sizeStart_y + emitter.sizeEnd_y) * 0.5f,
+                                0.1f))
+            propertiesChanged = true;
         if (renderEditableFloat("Size End Y", emitter.sizeEnd_y, 0.1f))
             propertiesChanged = true;
     }
@@ -283,6 +352,12 @@ void PropertyEditor::renderEmitterProperties(EmitterNode& emitter)
         if (renderEditableFloat("Blur Length", emitter.blurlength, 0.1f))
             propertiesChanged = true;
     }
+
+    if (propertiesChanged)
+    {
+        editor.touchEmitter(index);
+    }
+    propertiesChanged = propertiesChanged || changedBefore;
 }
 
 void PropertyEditor::renderUpdateTypeCombo(UpdateType& updateType)
@@ -352,6 +427,53 @@ bool PropertyEditor::renderColorEdit(const char* label, glm::vec3& color)
     return changed;
 }
 
+// Mid keys are disabled by a negative value; the checkbox switches between that and a starting value
+bool PropertyEditor::renderOptionalColorEdit(const char* label, glm::vec3& color, const glm::vec3& fallback)
+{
+    ImGui::PushID(label);
+    bool enabled = color.r >= 0.0f && color.g >= 0.0f && color.b >= 0.0f;
+    bool changed = false;
+    if (ImGui::Checkbox("##enabled", &enabled))
+    {
+        color = enabled ? fallback : glm::vec3(-1.0f);
+        changed = true;
+    }
+    ImGui::SameLine();
+    ImGui::BeginDisabled(!enabled);
+    glm::vec3 shown = enabled ? color : fallback;
+    if (renderColorEdit(label, shown) && enabled)
+    {
+        color = shown;
+        changed = true;
+    }
+    ImGui::EndDisabled();
+    ImGui::PopID();
+    return changed;
+}
+
+bool PropertyEditor::renderOptionalFloat(const char* label, float& value, float fallback, float speed)
+{
+    ImGui::PushID(label);
+    bool enabled = value >= 0.0f;
+    bool changed = false;
+    if (ImGui::Checkbox("##enabled", &enabled))
+    {
+        value = enabled ? fallback : -1.0f;
+        changed = true;
+    }
+    ImGui::SameLine();
+    ImGui::BeginDisabled(!enabled);
+    float shown = enabled ? value : fallback;
+    if (ImGui::DragFloat(label, &shown, speed, 0.0f, FLT_MAX) && enabled)
+    {
+        value = shown;
+        changed = true;
+    }
+    ImGui::EndDisabled();
+    ImGui::PopID();
+    return changed;
+}
+
 bool PropertyEditor::renderVec3Edit(const char* label, glm::vec3& vec)
 {
     float vecArray[3] = {vec.x, vec.y, vec.z};
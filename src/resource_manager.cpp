@@ -0,0 +1,363 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "resource_manager.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+
+// ERF and KEY/BIF files are little endian, as are all platforms we build for
+
+namespace
+{
+    constexpr size_t ERF_HEADER_SIZE = 160;
+    constexpr size_t ERF_RESOURCE_SIZE = 8;
+    constexpr size_t KEY_HEADER_SIZE = 64;
+    constexpr size_t KEY_FILE_SIZE = 12;
+    constexpr size_t KEY_ENTRY_SIZE = 22;
+    constexpr size_t BIF_HEADER_SIZE = 20;
+    constexpr size_t BIF_ENTRY_SIZE = 16;
+    constexpr uint32_t BIF_INDEX_MASK = 0xFFFFF; // Low 20 bits of a KEY resource id, the high 12 select the BIF
+
+    // Bounds-checked reads from a mapped file
+    class BinaryReader
+    {
+    public:
+        explicit BinaryReader(const MappedFile& file) : data(file.data()), size(file.size()) {}
+
+        bool has(size_t offset, size_t length) const { return offset <= size && length <= size - offset; }
+
+        template <typename T>
+        T read(size_t offset) const
+        {
+            T value{};
+            if (has(offset, sizeof(T)))
+            {
+                std::memcpy(&value, data + offset, sizeof(T));
+            }
+            return value;
+        }
+
+        bool matches(size_t offset, const char* text) const
+        {
+            size_t length = std::strlen(text);
+            return has(offset, length) && std::memcmp(data + offset, text, length) == 0;
+        }
+
+        // Fixed-size, NUL padded resref, lowercased
+        std::string readResRef(size_t offset, size_t length) const
+        {
+            if (!has(offset, length))
+                return {};
+            const char* start = reinterpret_cast<const char*>(data + offset);
+            std::string resref(start, strnlen(start, length));
+            std::transform(resref.begin(), resref.end(), resref.begin(),
+                           [](unsigned char c) { return std::tolower(c); });
+            return resref;
+        }
+
+    private:
+        const unsigned char* data;
+        size_t size;
+    };
+
+    std::string makeKey(std::string_view resref, uint16_t type)
+    {
+        std::string key(resref);
+        std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return std::tolower(c); });
+        key += ':';
+        key += std::to_string(type);
+        return key;
+    }
+
+    std::shared_ptr<const MappedFile> openMapped(const std::string& path)
+    {
+        auto file = std::make_shared<MappedFile>();
+        if (!file->open(path))
+            return nullptr;
+        return file;
+    }
+
+    // KEY files were written on Windows, the BIF names they list may not match the case on disk
+    std::string findFileIgnoringCase(const std::filesystem::path& path)
+    {
+        std::error_code ec;
+        if (std::filesystem::exists(path, ec))
+            return path.string();
+
+        auto lower = [](std::string text)
+        {
+            std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+            return text;
+        };
+        std::string wanted = lower(path.filename().string());
+        for (std::filesystem::directory_iterator it(path.parent_path(), ec), end; !ec && it != end; it.increment(ec))
+        {
+            if (lower(it->path().filename().string()) == wanted)
+                return it->path().string();
+        }
+        return path.string();
+    }
+} // namespace
+
+bool ResourceManager::mount(const std::string& path)
+{
+    Archive archive;
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+
+    bool ok = extension == ".key" ? readKEY(path, archive) : readERF(path, archive);
+    if (!ok)
+        return false;
+
+    mounts.push_back({path, archive.entries.size()});
+    archives.push_back(std::move(archive));
+    rebuildIndex();
+    return true;
+}
+
+void ResourceManager::unmount(size_t mountIndex)
+{
+    if (mountIndex >= mounts.size())
+        return;
+    mounts.erase(mounts.begin() + static_cast<std::ptrdiff_t>(mountIndex));
+    archives.erase(archives.begin() + static_cast<std::ptrdiff_t>(mountIndex));
+    rebuildIndex();
+}
+
+void ResourceManager::clear()
+{
+    mounts.clear();
+    archives.clear();
+    rebuildIndex();
+}
+
+ResourceManager::Resource ResourceManager::find(std::string_view resref, ResourceType type) const
+{
+    auto it = index.find(makeKey(resref, static_cast<uint16_t>(type)));
+    if (it == index.end())
+        return {};
+
+    const Archive& archive = archives[it->second.archive];
+    const Entry& entry = archive.entries[it->second.entry];
+    Resource resource;
+    resource.file = archive.files[entry.file];
+    resource.data = resource.file->data() + entry.offset;
+    resource.size = entry.size;
+    resource.location = archive.filePaths[entry.file] + ":" + entry.resref + "." + getExtension(type);
+    resource.time = archive.fileTimes[entry.file];
+    return resource;
+}
+
+std::vector<std::string> ResourceManager::list(ResourceType type) const
+{
+    std::vector<std::string> resrefs;
+    for (const auto& [key, location] : index)
+    {
+        const Entry& entry = archives[location.archive].entries[location.entry];
+        if (entry.type == static_cast<uint16_t>(type))
+            resrefs.push_back(entry.resref);
+    }
+    std::sort(resrefs.begin(), resrefs.end());
+    return resrefs;
+}
+
+const char* ResourceManager::getExtension(ResourceType type)
+{
+    switch (type)
+    {
+    case ResourceType::TGA:
+        return "tga";
+    case ResourceType::MDL:
+        return "mdl";
+    case ResourceType::DDS:
+        return "dds";
+    }
+    return "";
+}
+
+bool ResourceManager::readERF(const std::string& path, Archive& archive)
+{
+    auto file = openMapped(path);
+    if (!file)
+    {
+        std::cerr << "Failed to open archive: " << path << std::endl;
+        return false;
+    }
+
+    BinaryReader reader(*file);
+    bool knownType = reader.matches(0, "ERF ") || reader.matches(0, "HAK ") || reader.matches(0, "MOD ") ||
+        reader.matches(0, "NWM ");
+    // V1.1 widens resrefs to 32 characters
+    size_t resrefLength = reader.matches(4, "V1.0") ? 16 : reader.matches(4, "V1.1") ? 32 : 0;
+    if (!knownType || !resrefLength || !reader.has(0, ERF_HEADER_SIZE))
+    {
+        std::cerr << "Not an ERF V1.0/V1.1 archive: " << path << std::endl;
+        return false;
+    }
+
+    uint32_t entryCount = reader.read<uint32_t>(16);
+    uint32_t keyListOffset = reader.read<uint32_t>(24);
+    uint32_t resourceListOffset = reader.read<uint32_t>(28);
+    size_t keySize = resrefLength + 8;
+    if (!reader.has(keyListOffset, static_cast<size_t>(entryCount) * keySize) ||
+        !reader.has(resourceListOffset, static_cast<size_t>(entryCount) * ERF_RESOURCE_SIZE))
+    {
+        std::cerr << "Truncated ERF archive: " << path << std::endl;
+        return false;
+    }
+
+    archive.entries.reserve(entryCount);
+    for (uint32_t i = 0; i < entryCount; ++i)
+    {
+        size_t key = keyListOffset + i * keySize;
+        uint32_t resourceId = reader.read<uint32_t>(key + resrefLength);
+        if (resourceId >= entryCount)
+            resourceId = i;
+
+        size_t resource = resourceListOffset + static_cast<size_t>(resourceId) * ERF_RESOURCE_SIZE;
+        Entry entry;
+        entry.resref = reader.readResRef(key, resrefLength);
+        entry.type = reader.read<uint16_t>(key + resrefLength + 4);
+        entry.file = 0;
+        entry.offset = reader.read<uint32_t>(resource);
+        entry.size = reader.read<uint32_t>(resource + 4);
+        if (!entry.resref.empty() && reader.has(entry.offset, entry.size))
+            archive.entries.push_back(std::move(entry));
+    }
+
+    addFile(archive, std::move(file), path);
+    return true;
+}
+
+bool ResourceManager::readKEY(const std::string& path, Archive& archive)
+{
+    MappedFile keyFile;
+    if (!keyFile.open(path))
+    {
+        std::cerr << "Failed to open key file: " << path << std::endl;
+        return false;
+    }
+
+    BinaryReader reader(keyFile);
+    if (!reader.matches(0, "KEY V1  ") || !reader.has(0, KEY_HEADER_SIZE))
+    {
+        std::cerr << "Not a KEY V1 file: " << path << std::endl;
+        return false;
+    }
+
+    uint32_t bifCount = reader.read<uint32_t>(8);
+    uint32_t keyCount = reader.read<uint32_t>(12);
+    uint32_t fileTableOffset = reader.read<uint32_t>(16);
+    uint32_t keyTableOffset = reader.read<uint32_t>(20);
+    if (!reader.has(fileTableOffset, static_cast<size_t>(bifCount) * KEY_FILE_SIZE) ||
+        !reader.has(keyTableOffset, static_cast<size_t>(keyCount) * KEY_ENTRY_SIZE))
+    {
+        std::cerr << "Truncated key file: " << path << std::endl;
+        return false;
+    }
+
+    // BIF paths are relative to the directory of the KEY, with Windows separators
+    std::filesystem::path root = std::filesystem::path(path).parent_path();
+    std::vector<int> bifFiles(bifCount, -1); // Index into archive.files, -1 if the BIF is missing
+    for (uint32_t i = 0; i < bifCount; ++i)
+    {
+        size_t entry = fileTableOffset + static_cast<size_t>(i) * KEY_FILE_SIZE;
+        uint32_t nameOffset = reader.read<uint32_t>(entry + 4);
+        uint16_t nameSize = reader.read<uint16_t>(entry + 8);
+        if (!reader.has(nameOffset, nameSize))
+            continue;
+
+        const char* nameStart = reinterpret_cast<const char*>(keyFile.data() + nameOffset);
+        std::string name(nameStart, strnlen(nameStart, nameSize));
+        std::replace(name.begin(), name.end(), '\\', '/');
+        std::string bifPath = findFileIgnoringCase(root / name);
+
+        auto bif = openMapped(bifPath);
+        if (!bif || !BinaryReader(*bif).matches(0, "BIFFV1  ") || bif->size() < BIF_HEADER_SIZE)
+        {
+            std::cerr << "Skipping missing or invalid BIF: " << bifPath << std::endl;
+            continue;
+        }
+        bifFiles[i] = static_cast<int>(archive.files.size());
+        addFile(archive, std::move(bif), bifPath);
+    }
+
+    archive.entries.reserve(keyCount);
+    for (uint32_t i = 0; i < keyCount; ++i)
+    {
+        size_t key = keyTableOffset + static_cast<size_t>(i) * KEY_ENTRY_SIZE;
+        uint32_t resourceId = reader.read<uint32_t>(key + 18);
+        uint32_t bifIndex = resourceId >> 20;
+        if (bifIndex >= bifCount || bifFiles[bifIndex] < 0)
+            continue;
+
+        const MappedFile& bif = *archive.files[bifFiles[bifIndex]];
+        BinaryReader bifReader(bif);
+        uint32_t variableCount = bifReader.read<uint32_t>(8);
+        uint32_t variableTableOffset = bifReader.read<uint32_t>(16);
+        uint32_t resourceIndex = resourceId & BIF_INDEX_MASK;
+        size_t bifEntry = variableTableOffset + static_cast<size_t>(resourceIndex) * BIF_ENTRY_SIZE;
+        if (resourceIndex >= variableCount || !bifReader.has(bifEntry, BIF_ENTRY_SIZE))
+            continue;
+
+        Entry entry;
+        entry.resref = reader.readResRef(key, 16);
+        entry.type = reader.read<uint16_t>(key + 16);
+        entry.file = static_cast<uint32_t>(bifFiles[bifIndex]);
+        entry.offset = bifReader.read<uint32_t>(bifEntry + 4);
+        entry.size = bifReader.read<uint32_t>(bifEntry + 8);
+        if (!entry.resref.empty() && bifReader.has(entry.offset, entry.size))
+            archive.entries.push_back(std::move(entry));
+    }
+    return true;
+}
+
+void ResourceManager::addFile(Archive& archive, std::shared_ptr<const MappedFile> file, const std::string& path)
+{
+    // Absolute, so archives with the same name in different directories tell their resources apart. The time is
+    // taken now, as the mapping keeps the data of a file that is replaced on disk while it is mounted.
+    std::error_code ec;
+    std::filesystem::path absolute = std::filesystem::absolute(path, ec);
+    auto time = std::filesystem::last_write_time(path, ec);
+
+    archive.files.push_back(std::move(file));
+    archive.filePaths.push_back(absolute.empty() ? path : absolute.lexically_normal().string());
+    archive.fileTimes.push_back(ec ? 0 : static_cast<int64_t>(time.time_since_epoch().count()));
+}
+
+void ResourceManager::rebuildIndex()
+{
+    // Later mounts overwrite what earlier ones put in, within one archive the last entry wins
+    index.clear();
+    for (size_t a = 0; a < archives.size(); ++a)
+    {
+        const auto& entries = archives[a].entries;
+        for (size_t e = 0; e < entries.size(); ++e)
+        {
+            index.insert_or_assign(makeKey(entries[e].resref, entries[e].type),
+                                   Location{static_cast<uint32_t>(a), static_cast<uint32_t>(e)});
+        }
+    }
+    ++revision;
+}
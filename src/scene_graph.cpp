@@ -0,0 +1,322 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "scene_graph.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <unordered_map>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SCENE_GRAPH_SSE2 1
+#endif
+
+namespace
+{
+    glm::mat4 composeLocal(const glm::vec3& position, const glm::quat& orientation)
+    {
+        glm::mat4 local = glm::mat4_cast(orientation);
+        local[3] = glm::vec4(position, 1.0f);
+        return local;
+    }
+} // namespace
+
+void SceneGraph::setModelNodes(const std::vector<ModelNode>& modelNodes)
+{
+    std::vector<Node> emitterNodes(nodes.begin() + modelNodeCount, nodes.end());
+
+    nodes.clear();
+    nodes.reserve(modelNodes.size() + emitterNodes.size());
+    for (const auto& modelNode : modelNodes)
+    {
+        Node node;
+        node.name = modelNode.name;
+        node.parentName = modelNode.parent;
+        node.isDummy = modelNode.type == "dummy";
+        node.position = modelNode.position;
+        node.orientation = modelNode.orientation;
+        node.local = composeLocal(node.position, node.orientation);
+        nodes.push_back(std::move(node));
+    }
+    modelNodeCount = modelNodes.size();
+
+    for (auto& node : emitterNodes)
+    {
+        node.dirty = true;
+        nodes.push_back(std::move(node));
+    }
+    resolveParents();
+}
+
+bool SceneGraph::syncStructure(const std::vector<EmitterNode>& emitters)
+{
+    bool changed = getEmitterCount() != emitters.size();
+    if (changed)
+    {
+        nodes.resize(modelNodeCount + emitters.size());
+    }
+
+    for (size_t i = 0; i < emitters.size(); ++i)
+    {
+        Node& node = nodes[modelNodeCount + i];
+        if (node.name != emitters[i].name || node.parentName != emitters[i].parent)
+        {
+            node.name = emitters[i].name;
+            node.parentName = emitters[i].parent;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+void SceneGraph::resolveParents()
+{
+    // Emitters shadow model nodes of the same name, matching how the MDL writer resolves parents
+    std::unordered_map<std::string, int> byName;
+    for (size_t i = modelNodeCount; i < nodes.size(); ++i)
+    {
+        byName.emplace(nodes[i].name, static_cast<int>(i));
+    }
+    for (size_t i = 0; i < modelNodeCount; ++i)
+    {
+        byName.emplace(nodes[i].name, static_cast<int>(i));
+    }
+
+    std::vector<std::vector<int>> children(nodes.size());
+    std::vector<int> roots;
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        auto it = byName.find(nodes[i].parentName);
+        nodes[i].parent = it != byName.end() && it->second != static_cast<int>(i) ? it->second : -1;
+        nodes[i].dirty = true;
+        if (nodes[i].parent >= 0)
+            children[nodes[i].parent].push_back(static_cast<int>(i));
+        else
+            roots.push_back(static_cast<int>(i));
+    }
+
+    // Depth-first from the roots; nodes caught in a parent cycle are never reached and become roots
+    order.clear();
+    order.reserve(nodes.size());
+    std::vector<bool> visited(nodes.size(), false);
+    std::vector<int> stack;
+    auto visitFrom = [&](int root)
+    {
+        stack.push_back(root);
+        while (!stack.empty())
+        {
+            int index = stack.back();
+            stack.pop_back();
+            visited[index] = true;
+            order.push_back(index);
+            for (int child : children[index])
+            {
+                if (!visited[child])
+                    stack.push_back(child);
+            }
+        }
+    };
+
+    for (int root : roots)
+    {
+        visitFrom(root);
+    }
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        if (!visited[i])
+        {
+            nodes[i].parent = -1;
+            visitFrom(static_cast<int>(i));
+        }
+    }
+}
+
+void SceneGraph::OrientationBatch::clear()
+{
+    emitters.clear();
+    for (int c = 0; c < 4; ++c)
+    {
+        from[c].clear();
+        to[c].clear();
+    }
+    weight.clear();
+}
+
+void SceneGraph::OrientationBatch::push(uint32_t emitter, const glm::quat& a, const glm::quat& b, float t)
+{
+    emitters.push_back(emitter);
+    const float fromValues[4] = {a.x, a.y, a.z, a.w};
+    const float toValues[4] = {b.x, b.y, b.z, b.w};
+    for (int c = 0; c < 4; ++c)
+    {
+        from[c].push_back(fromValues[c]);
+        to[c].push_back(toValues[c]);
+    }
+    weight.push_back(t);
+}
+
+void SceneGraph::OrientationBatch::evaluate()
+{
+    float* fx = from[0].data();
+    float* fy = from[1].data();
+    float* fz = from[2].data();
+    float* fw = from[3].data();
+    const float* tx = to[0].data();
+    const float* ty = to[1].data();
+    const float* tz = to[2].data();
+    const float* tw = to[3].data();
+    const size_t count = weight.size();
+    size_t i = 0;
+
+#ifdef SCENE_GRAPH_SSE2
+    // Four quaternions per iteration, same arithmetic as QuaternionTrack::nlerp
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 ax = _mm_loadu_ps(fx + i), ay = _mm_loadu_ps(fy + i);
+        __m128 az = _mm_loadu_ps(fz + i), aw = _mm_loadu_ps(fw + i);
+        __m128 bx = _mm_loadu_ps(tx + i), by = _mm_loadu_ps(ty + i);
+        __m128 bz = _mm_loadu_ps(tz + i), bw = _mm_loadu_ps(tw + i);
+        __m128 t = _mm_loadu_ps(weight.data() + i);
+
+        // Flip the target onto the same hemisphere to take the shorter arc
+        __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)),
+                                _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+        __m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), signBit);
+        bx = _mm_xor_ps(bx, flip);
+        by = _mm_xor_ps(by, flip);
+        bz = _mm_xor_ps(bz, flip);
+        bw = _mm_xor_ps(bw, flip);
+
+        __m128 qx = _mm_add_ps(ax, _mm_mul_ps(_mm_sub_ps(bx, ax), t));
+        __m128 qy = _mm_add_ps(ay, _mm_mul_ps(_mm_sub_ps(by, ay), t));
+        __m128 qz = _mm_add_ps(az, _mm_mul_ps(_mm_sub_ps(bz, az), t));
+        __m128 qw = _mm_add_ps(aw, _mm_mul_ps(_mm_sub_ps(bw, aw), t));
+
+        __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)),
+                                     _mm_add_ps(_mm_mul_ps(qz, qz), _mm_mul_ps(qw, qw)));
+        __m128 inverseLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSq));
+
+        _mm_storeu_ps(fx + i, _mm_mul_ps(qx, inverseLength));
+        _mm_storeu_ps(fy + i, _mm_mul_ps(qy, inverseLength));
+        _mm_storeu_ps(fz + i, _mm_mul_ps(qz, inverseLength));
+        _mm_storeu_ps(fw + i, _mm_mul_ps(qw, inverseLength));
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        glm::quat q = QuaternionTrack::nlerp(glm::quat(fw[i], fx[i], fy[i], fz[i]),
+                                             glm::quat(tw[i], tx[i], ty[i], tz[i]), weight[i]);
+        fx[i] = q.x;
+        fy[i] = q.y;
+        fz[i] = q.z;
+        fw[i] = q.w;
+    }
+}
+
+void SceneGraph::gatherOrientations(const std::vector<EmitterNode>& emitters, float time)
+{
+    orientationBatch.clear();
+    for (size_t i = 0; i < emitters.size(); ++i)
+    {
+        const QuaternionTrack& track = emitters[i].orientationKeys;
+        if (track.keyframes.empty())
+            continue;
+
+        glm::quat from, to;
+        float weight;
+        track.findBlend(time, nodes[modelNodeCount + i].orientationCursor.segment, from, to, weight);
+        orientationBatch.push(static_cast<uint32_t>(i), from, to, weight);
+    }
+    orientationBatch.evaluate();
+}
+
+void SceneGraph::update(const std::vector<EmitterNode>& emitters, float time)
+{
+    if (syncStructure(emitters))
+    {
+        resolveParents();
+    }
+
+    // Animated orientations of all emitters in one pass
+    gatherOrientations(emitters, time);
+
+    // Only emitters that moved or rotated since the last update get a new local matrix
+    size_t nextAnimated = 0;
+    for (size_t i = 0; i < emitters.size(); ++i)
+    {
+        Node& node = nodes[modelNodeCount + i];
+        glm::vec3 position = emitters[i].getAnimatedPosition(time, node.positionCursor);
+
+        glm::quat orientation = node.orientation;
+        bool animated = nextAnimated < orientationBatch.emitters.size() && orientationBatch.emitters[nextAnimated] == i;
+        if (animated)
+        {
+            orientation = orientationBatch.result(nextAnimated++);
+        }
+        else if (node.dirty || node.orientationAnimated || node.rotationAngles != emitters[i].rotationAngles)
+        {
+            orientation = emitters[i].getOrientation();
+        }
+        node.orientationAnimated = animated;
+        node.rotationAngles = emitters[i].rotationAngles;
+
+        if (node.dirty || node.position != position || node.orientation != orientation)
+        {
+            node.position = position;
+            node.orientation = orientation;
+            node.local = composeLocal(node.position, node.orientation);
+            node.dirty = true;
+        }
+    }
+
+    // A dirty parent makes its whole subtree dirty; order guarantees parents are visited first
+    for (int index : order)
+    {
+        Node& node = nodes[index];
+        if (node.parent >= 0 && nodes[node.parent].dirty)
+            node.dirty = true;
+        if (!node.dirty)
+            continue;
+        node.world = node.parent >= 0 ? nodes[node.parent].world * node.local : node.local;
+    }
+
+    // Cleared afterwards so every descendant sees its parent's flag during the walk
+    for (auto& node : nodes)
+    {
+        node.dirty = false;
+    }
+}
+
+glm::mat4 SceneGraph::getEmitterParentWorld(size_t index) const
+{
+    int parent = nodes[modelNodeCount + index].parent;
+    return parent >= 0 ? nodes[parent].world : glm::mat4(1.0f);
+}
+
+std::vector<glm::vec3> SceneGraph::getDummyPositions() const
+{
+    std::vector<glm::vec3> positions;
+    for (size_t i = 0; i < modelNodeCount; ++i)
+    {
+        if (nodes[i].isDummy)
+            positions.push_back(glm::vec3(nodes[i].world[3]));
+    }
+    return positions;
+}
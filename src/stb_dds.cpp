@@ -17,16 +17,28 @@
  */
 
 #include "stb_dds.hpp"
+#include <climits>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include "mapped_file.hpp"
+#include "thread_pool.hpp"
+
+#if !defined(STB_DDS_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define STB_DDS_SSE2 1
+#endif
+
+// Textures with at least this many blocks are decoded in row bands on the shared thread pool
+#define PARALLEL_DECODE_BLOCKS 4096
 
 // DDS constants
 #define DDS_MAGIC 0x20534444
 #define FOURCC_DXT1 0x31545844
 #define FOURCC_DXT3 0x33545844
 #define FOURCC_DXT5 0x35545844
+#define DDSD_MIPMAPCOUNT 0x20000
 
 // Bioware DDS header structure
 struct BioDDSHeader
@@ -76,81 +88,47 @@ static void rgb565_to_rgb888(uint16_t color565, uint8_t* rgb)
     rgb[2] = (color565 & 0x1F) << 3; // Blue: 5 bits -> 8 bits
 }
 
-static void decompress_dxt1_block(const uint8_t* block, uint8_t* output, int width, int channels)
+// Texels are packed as R | G << 8 | B << 16 | A << 24, which is RGBA byte order in memory
+static uint32_t pack_rgba(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+{
+    return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+// Four colors of a DXT color block. Only DXT1 has the 3-color mode with transparent black,
+// DXT3 and DXT5 always interpolate 4 colors.
+static void build_color_palette(const uint8_t* colorBlock, bool allowThreeColor, uint32_t palette[4])
 {
     // Read color endpoints
-    uint16_t color0 = block[0] | (block[1] << 8);
-    uint16_t color1 = block[2] | (block[3] << 8);
+    uint16_t color0 = colorBlock[0] | (colorBlock[1] << 8);
+    uint16_t color1 = colorBlock[2] | (colorBlock[3] << 8);
 
     // Convert RGB565 to RGB888
-    uint8_t colors[4][3];
-    rgb565_to_rgb888(color0, colors[0]);
-    rgb565_to_rgb888(color1, colors[1]);
+    uint8_t c0[3], c1[3];
+    rgb565_to_rgb888(color0, c0);
+    rgb565_to_rgb888(color1, c1);
+
+    palette[0] = pack_rgba(c0[0], c0[1], c0[2], 255);
+    palette[1] = pack_rgba(c1[0], c1[1], c1[2], 255);
 
-    // Interpolate colors
-    if (color0 > color1)
+    if (!allowThreeColor || color0 > color1)
     {
         // 4-color mode
-        colors[2][0] = (2 * colors[0][0] + colors[1][0]) / 3;
-        colors[2][1] = (2 * colors[0][1] + colors[1][1]) / 3;
-        colors[2][2] = (2 * colors[0][2] + colors[1][2]) / 3;
-
-        colors[3][0] = (colors[0][0] + 2 * colors[1][0]) / 3;
-        colors[3][1] = (colors[0][1] + 2 * colors[1][1]) / 3;
-        colors[3][2] = (colors[0][2] + 2 * colors[1][2]) / 3;
+        palette[2] = pack_rgba((2 * c0[0] + c1[0]) / 3, (2 * c0[1] + c1[1]) / 3, (2 * c0[2] + c1[2]) / 3, 255);
+        palette[3] = pack_rgba((c0[0] + 2 * c1[0]) / 3, (c0[1] + 2 * c1[1]) / 3, (c0[2] + 2 * c1[2]) / 3, 255);
     }
     else
     {
         // 3-color mode with transparent black
-        colors[2][0] = (colors[0][0] + colors[1][0]) / 2;
-        colors[2][1] = (colors[0][1] + colors[1][1]) / 2;
-        colors[2][2] = (colors[0][2] + colors[1][2]) / 2;
-
-        colors[3][0] = colors[3][1] = colors[3][2] = 0; // Transparent black
-    }
-
-    // Read color indices (2 bits per pixel)
-    uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (block[7] << 24);
-
-    for (int y = 0; y < 4; ++y)
-    {
-        for (int x = 0; x < 4; ++x)
-        {
-            int pixelIndex = y * 4 + x;
-            int colorIndex = (indices >> (pixelIndex * 2)) & 0x3;
-
-            int outputIndex = (y * width + x) * channels;
-            if (outputIndex >= 0)
-            {
-                output[outputIndex + 0] = colors[colorIndex][0]; // R
-                output[outputIndex + 1] = colors[colorIndex][1]; // G
-                output[outputIndex + 2] = colors[colorIndex][2]; // B
-                if (channels == 4)
-                {
-                    output[outputIndex + 3] = (color0 > color1 || colorIndex < 3) ? 255 : 0; // A
-                }
-            }
-        }
+        palette[2] = pack_rgba((c0[0] + c1[0]) / 2, (c0[1] + c1[1]) / 2, (c0[2] + c1[2]) / 2, 255);
+        palette[3] = 0;
     }
 }
 
-static void decompress_dxt5_block(const uint8_t* block, uint8_t* output, int width)
+// Eight interpolated alpha values of a DXT5 alpha block
+static void build_alpha_palette(const uint8_t* alphaBlock, uint8_t alphas[8])
 {
-    // DXT5 has interpolated alpha (first 8 bytes) + DXT1 color (last 8 bytes)
-
-    // Read alpha endpoints
-    uint8_t alpha0 = block[0];
-    uint8_t alpha1 = block[1];
-
-    // Read alpha indices (3 bits per pixel)
-    uint64_t alphaIndices = 0;
-    for (int i = 2; i < 8; ++i)
-    {
-        alphaIndices |= static_cast<uint64_t>(block[i]) << ((i - 2) * 8);
-    }
-
-    // Generate alpha palette
-    uint8_t alphas[8];
+    uint8_t alpha0 = alphaBlock[0];
+    uint8_t alpha1 = alphaBlock[1];
     alphas[0] = alpha0;
     alphas[1] = alpha1;
 
@@ -172,110 +150,90 @@ static void decompress_dxt5_block(const uint8_t* block, uint8_t* output, int wid
         alphas[6] = 0; // Transparent
         alphas[7] = 255; // Opaque
     }
+}
 
-    // Read color data (last 8 bytes)
-    const uint8_t* colorBlock = block + 8;
-    uint16_t color0 = colorBlock[0] | (colorBlock[1] << 8);
-    uint16_t color1 = colorBlock[2] | (colorBlock[3] << 8);
-
-    // Convert colors
-    uint8_t colors[4][3];
-    rgb565_to_rgb888(color0, colors[0]);
-    rgb565_to_rgb888(color1, colors[1]);
-
-    // Always use 4-color mode for DXT5
-    colors[2][0] = (2 * colors[0][0] + colors[1][0]) / 3;
-    colors[2][1] = (2 * colors[0][1] + colors[1][1]) / 3;
-    colors[2][2] = (2 * colors[0][2] + colors[1][2]) / 3;
-
-    colors[3][0] = (colors[0][0] + 2 * colors[1][0]) / 3;
-    colors[3][1] = (colors[0][1] + 2 * colors[1][1]) / 3;
-    colors[3][2] = (colors[0][2] + 2 * colors[1][2]) / 3;
-
-    // Read color indices
-    uint32_t colorIndices = colorBlock[4] | (colorBlock[5] << 8) | (colorBlock[6] << 16) | (colorBlock[7] << 24);
+// Decode a whole 4x4 block to 16 packed RGBA texels in row order
+static void decode_block(int fourcc, const uint8_t* block, uint32_t texels[16])
+{
+    // DXT3/DXT5 store alpha in the first 8 bytes, followed by a DXT1-style color block
+    const uint8_t* colorBlock = (fourcc == 1) ? block : block + 8;
+    uint32_t colors[4];
+    build_color_palette(colorBlock, fourcc == 1, colors);
 
-    for (int y = 0; y < 4; ++y)
+    uint8_t alphas[8];
+    uint64_t alphaIndices = 0; // 3 bits per texel (DXT5)
+    if (fourcc == 5)
     {
-        for (int x = 0; x < 4; ++x)
+        build_alpha_palette(block, alphas);
+        for (int i = 2; i < 8; ++i)
         {
-            int pixelIndex = y * 4 + x;
-
-            // Extract alpha (3 bits)
-            int alphaIndex = (alphaIndices >> (pixelIndex * 3)) & 0x7;
-            uint8_t alpha = alphas[alphaIndex];
-
-            // Extract color (2 bits)
-            int colorIndex = (colorIndices >> (pixelIndex * 2)) & 0x3;
-
-            int outputIndex = (y * width + x) * 4;
-            if (outputIndex >= 0)
-            {
-                output[outputIndex + 0] = colors[colorIndex][0]; // R
-                output[outputIndex + 1] = colors[colorIndex][1]; // G
-                output[outputIndex + 2] = colors[colorIndex][2]; // B
-                output[outputIndex + 3] = alpha; // A
-            }
+            alphaIndices |= static_cast<uint64_t>(block[i]) << ((i - 2) * 8);
         }
     }
-}
 
-static void decompress_dxt3_block(const uint8_t* block, uint8_t* output, int width)
-{
-    // DXT3 has explicit alpha (4 bits per pixel) + DXT1 color
-
-    // Read alpha data (first 8 bytes)
-    uint64_t alphaData = 0;
-    for (int i = 0; i < 8; ++i)
+#ifdef STB_DDS_SSE2
+    // One row of 4 texels per iteration. Each lane tests the two bits of its own color index and picks the
+    // palette entry with mask blends, so no texel needs a scalar table lookup.
+    const __m128i lowBit = _mm_set_epi32(1 << 6, 1 << 4, 1 << 2, 1);
+    const __m128i highBit = _mm_set_epi32(2 << 6, 2 << 4, 2 << 2, 2);
+    const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+    const __m128i color0 = _mm_set1_epi32(static_cast<int>(colors[0]));
+    const __m128i color1 = _mm_set1_epi32(static_cast<int>(colors[1]));
+    const __m128i color2 = _mm_set1_epi32(static_cast<int>(colors[2]));
+    const __m128i color3 = _mm_set1_epi32(static_cast<int>(colors[3]));
+    const __m128i low01 = _mm_xor_si128(color0, color1);
+    const __m128i low23 = _mm_xor_si128(color2, color3);
+
+    for (int row = 0; row < 4; ++row)
     {
-        alphaData |= static_cast<uint64_t>(block[i]) << (i * 8);
-    }
+        __m128i indices = _mm_set1_epi32(colorBlock[4 + row]);
+        __m128i lowSet = _mm_cmpeq_epi32(_mm_and_si128(indices, lowBit), lowBit);
+        __m128i highSet = _mm_cmpeq_epi32(_mm_and_si128(indices, highBit), highBit);
 
-    // Read color data (last 8 bytes)
-    const uint8_t* colorBlock = block + 8;
-    uint16_t color0 = colorBlock[0] | (colorBlock[1] << 8);
-    uint16_t color1 = colorBlock[2] | (colorBlock[3] << 8);
-
-    // Convert colors
-    uint8_t colors[4][3];
-    rgb565_to_rgb888(color0, colors[0]);
-    rgb565_to_rgb888(color1, colors[1]);
+        // a ^ ((a ^ b) & mask) selects b where mask is set
+        __m128i first = _mm_xor_si128(color0, _mm_and_si128(low01, lowSet));
+        __m128i second = _mm_xor_si128(color2, _mm_and_si128(low23, lowSet));
+        __m128i result = _mm_xor_si128(first, _mm_and_si128(_mm_xor_si128(first, second), highSet));
 
-    // Always use 4-color mode for DXT3
-    colors[2][0] = (2 * colors[0][0] + colors[1][0]) / 3;
-    colors[2][1] = (2 * colors[0][1] + colors[1][1]) / 3;
-    colors[2][2] = (2 * colors[0][2] + colors[1][2]) / 3;
-
-    colors[3][0] = (colors[0][0] + 2 * colors[1][0]) / 3;
-    colors[3][1] = (colors[0][1] + 2 * colors[1][1]) / 3;
-    colors[3][2] = (colors[0][2] + 2 * colors[1][2]) / 3;
+        if (fourcc == 3)
+        {
+            // Explicit 4-bit alpha, scaled to 8 bits
+            uint32_t bits = block[row * 2] | (block[row * 2 + 1] << 8);
+            __m128i alpha = _mm_set_epi32(((bits >> 12) & 0xF) * 17, ((bits >> 8) & 0xF) * 17,
+                                          ((bits >> 4) & 0xF) * 17, (bits & 0xF) * 17);
+            result = _mm_or_si128(_mm_and_si128(result, rgbMask), _mm_slli_epi32(alpha, 24));
+        }
+        else if (fourcc == 5)
+        {
+            // 8-entry lookups are cheaper as scalar loads than as 8 lane compares
+            uint32_t bits = static_cast<uint32_t>(alphaIndices >> (row * 12));
+            __m128i alpha = _mm_set_epi32(alphas[(bits >> 9) & 0x7], alphas[(bits >> 6) & 0x7],
+                                          alphas[(bits >> 3) & 0x7], alphas[bits & 0x7]);
+            result = _mm_or_si128(_mm_and_si128(result, rgbMask), _mm_slli_epi32(alpha, 24));
+        }
 
-    // Read color indices
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(texels + row * 4), result);
+    }
+#else
+    // Read color indices (2 bits per pixel)
     uint32_t colorIndices = colorBlock[4] | (colorBlock[5] << 8) | (colorBlock[6] << 16) | (colorBlock[7] << 24);
 
-    for (int y = 0; y < 4; ++y)
+    for (int i = 0; i < 16; ++i)
     {
-        for (int x = 0; x < 4; ++x)
+        uint32_t texel = colors[(colorIndices >> (i * 2)) & 0x3];
+        if (fourcc == 3)
         {
-            int pixelIndex = y * 4 + x;
-
-            // Extract alpha (4 bits)
-            int alphaIndex = pixelIndex * 4;
-            uint8_t alpha = ((alphaData >> alphaIndex) & 0xF) * 17; // Scale 4-bit to 8-bit
-
-            // Extract color (2 bits)
-            int colorIndex = (colorIndices >> (pixelIndex * 2)) & 0x3;
-
-            int outputIndex = (y * width + x) * 4;
-            if (outputIndex >= 0)
-            {
-                output[outputIndex + 0] = colors[colorIndex][0]; // R
-                output[outputIndex + 1] = colors[colorIndex][1]; // G
-                output[outputIndex + 2] = colors[colorIndex][2]; // B
-                output[outputIndex + 3] = alpha; // A
-            }
+            uint32_t alpha = ((block[i / 2] >> ((i % 2) * 4)) & 0xF) * 17; // Scale 4-bit to 8-bit
+            texel = (texel & 0x00FFFFFF) | (alpha << 24);
+        }
+        else if (fourcc == 5)
+        {
+            uint32_t alpha = alphas[(alphaIndices >> (i * 3)) & 0x7];
+            texel = (texel & 0x00FFFFFF) | (alpha << 24);
         }
+        texels[i] = texel;
     }
+#endif
 }
 
 static int is_bioware_dds(const uint8_t* data, int len)
@@ -332,69 +290,45 @@ int stbi_dds_test(char const* filename)
     return stbi_dds_test_memory(header, sizeof(header));
 }
 
-unsigned char* stbi_load_dds_from_memory(unsigned char const* buffer, int len, int* x, int* y, int* channels_in_file,
-                                         int desired_channels)
+static int level_size(int fourcc, int width, int height)
+{
+    int blockSize = (fourcc == 1) ? 8 : 16;
+    return ((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+}
+
+int stbi_dds_parse_memory(unsigned char const* buffer, int len, stbi_dds_compressed* out)
 {
     if (!stbi_dds_test_memory(buffer, len))
     {
-        return nullptr; // Not a DDS file
+        return 0; // Not a DDS file
     }
 
     const uint8_t* data = buffer;
+    int fourcc;
+    int levels;
 
     if (is_bioware_dds(data, len))
     {
-        // Load Bioware DDS
-        if (len < sizeof(BioDDSHeader))
-            return nullptr;
+        // Bioware DDS: DXT1 for 3 channels, DXT5 otherwise
+        if (len < (int)sizeof(BioDDSHeader))
+            return 0;
 
         BioDDSHeader header;
         memcpy(&header, data, sizeof(BioDDSHeader));
         data += sizeof(BioDDSHeader);
 
-        *x = header.width;
-        *y = header.height;
-        *channels_in_file = (header.channels == 3) ? 3 : 4;
-
-        int output_channels = desired_channels ? desired_channels : *channels_in_file;
-        unsigned char* result = (unsigned char*)malloc(*x * *y * output_channels);
-        if (!result)
-            return nullptr;
-
-        // Decompress blocks
-        int blocksWide = (*x + 3) / 4;
-        int blocksHigh = (*y + 3) / 4;
-
-        for (int blockY = 0; blockY < blocksHigh; ++blockY)
-        {
-            for (int blockX = 0; blockX < blocksWide; ++blockX)
-            {
-                int blockIndex = blockY * blocksWide + blockX;
-                const uint8_t* blockData = data + blockIndex * 8;
-
-                // Calculate output position
-                int outputX = blockX * 4;
-                int outputY = blockY * 4;
-                uint8_t* outputPtr = result + (outputY * *x + outputX) * output_channels;
-
-                if (header.channels == 3)
-                {
-                    decompress_dxt1_block(blockData, outputPtr, *x, output_channels);
-                }
-                else
-                {
-                    decompress_dxt5_block(blockData, outputPtr, *x);
-                }
-            }
-        }
+        out->width = header.width;
+        out->height = header.height;
+        fourcc = (header.channels == 3) ? 1 : 5;
 
-        return result;
+        // The header has no level count, mips follow level 0 down to 1x1 as far as the file goes
+        levels = STBI_DDS_MAX_LEVELS;
     }
     else
     {
-        // Load Standard DDS
-        if (len < 4 + sizeof(DDSHeader))
-            return nullptr;
+        // Standard DDS
+        if (len < 4 + (int)sizeof(DDSHeader))
+            return 0;
 
         // Skip magic number
         data += 4;
@@ -404,141 +338,156 @@ unsigned char* stbi_load_dds_from_memory(unsigned char const* buffer, int len, i
         data += sizeof(DDSHeader);
 
         if (header.size != 124)
-            return nullptr;
-
-        *x = header.width;
-        *y = header.height;
+            return 0;
 
-        int output_channels;
+        out->width = header.width;
+        out->height = header.height;
         if (header.ddspf.fourCC == FOURCC_DXT1)
-        {
-            *channels_in_file = 3;
-            output_channels = desired_channels ? desired_channels : 3;
-
-            auto* result = static_cast<unsigned char*>(malloc(*x * *y * output_channels));
-            if (!result)
-                return nullptr;
+            fourcc = 1;
+        else if (header.ddspf.fourCC == FOURCC_DXT3)
+            fourcc = 3;
+        else if (header.ddspf.fourCC == FOURCC_DXT5)
+            fourcc = 5;
+        else
+            return 0; // Unsupported format
 
-            int blocksWide = (*x + 3) / 4;
-            int blocksHigh = (*y + 3) / 4;
+        levels = ((header.flags & DDSD_MIPMAPCOUNT) && header.mipMapCount > 1) ? (int)header.mipMapCount : 1;
+    }
 
-            for (int blockY = 0; blockY < blocksHigh; ++blockY)
-            {
-                for (int blockX = 0; blockX < blocksWide; ++blockX)
-                {
-                    int blockIndex = blockY * blocksWide + blockX;
-                    const uint8_t* blockData = data + blockIndex * 8;
+    if (out->width <= 0 || out->height <= 0 || out->width > 16384 || out->height > 16384)
+        return 0;
 
-                    int outputX = blockX * 4;
-                    int outputY = blockY * 4;
-                    uint8_t* outputPtr = result + (outputY * *x + outputX) * output_channels;
+    out->fourcc = fourcc;
+    out->channels = (fourcc == 1) ? 3 : 4;
+    out->blocks = data;
+    out->size = level_size(fourcc, out->width, out->height);
 
-                    decompress_dxt1_block(blockData, outputPtr, *x, output_channels);
-                }
-            }
-
-            return result;
-        }
-        else if (header.ddspf.fourCC == FOURCC_DXT3)
-        {
-            *channels_in_file = 4;
-            output_channels = desired_channels ? desired_channels : 4;
+    // Keep the levels that are complete in the file and stop after 1x1
+    int available = len - (int)(data - buffer);
+    int offset = 0;
+    out->levels = 0;
+    for (int level = 0; level < levels && level < STBI_DDS_MAX_LEVELS; ++level)
+    {
+        int width = out->width >> level;
+        int height = out->height >> level;
+        if (width == 0 && height == 0)
+            break;
+
+        int size = level_size(fourcc, width ? width : 1, height ? height : 1);
+        if (size > available - offset)
+            break;
+
+        out->level_offsets[level] = offset;
+        out->levels = level + 1;
+        offset += size;
+    }
 
-            auto* result = static_cast<unsigned char*>(malloc(*x * *y * output_channels));
-            if (!result)
-                return nullptr;
+    return out->levels > 0; // 0 when even level 0 is truncated
+}
 
-            int blocksWide = (*x + 3) / 4;
-            int blocksHigh = (*y + 3) / 4;
+int stbi_dds_get_level(stbi_dds_compressed const* dds, int level, int* width, int* height,
+                       unsigned char const** blocks, int* size)
+{
+    if (level < 0 || level >= dds->levels)
+        return 0;
 
-            for (int blockY = 0; blockY < blocksHigh; ++blockY)
-            {
-                for (int blockX = 0; blockX < blocksWide; ++blockX)
-                {
-                    int blockIndex = blockY * blocksWide + blockX;
-                    const uint8_t* blockData = data + blockIndex * 16;
+    *width = (dds->width >> level) ? (dds->width >> level) : 1;
+    *height = (dds->height >> level) ? (dds->height >> level) : 1;
+    *blocks = dds->blocks + dds->level_offsets[level];
+    *size = level_size(dds->fourcc, *width, *height);
+    return 1;
+}
 
-                    int outputX = blockX * 4;
-                    int outputY = blockY * 4;
-                    uint8_t* outputPtr = result + (outputY * *x + outputX) * output_channels;
+int stbi_dds_decode_level_into(stbi_dds_compressed const* dds, int level, unsigned char* result,
+                               int output_channels)
+{
+    int width, height, size;
+    const unsigned char* blocks;
+    if (!stbi_dds_get_level(dds, level, &width, &height, &blocks, &size))
+        return 0;
 
-                    decompress_dxt3_block(blockData, outputPtr, *x);
-                }
-            }
+    int fourcc = dds->fourcc;
+    int blockSize = (fourcc == 1) ? 8 : 16;
+    int blocksWide = (width + 3) / 4;
+    int blocksHigh = (height + 3) / 4;
 
-            return result;
-        }
-        else if (header.ddspf.fourCC == FOURCC_DXT5)
+    // Blocks always cover 4x4 texels, the ones on the right and bottom edge of levels that are not a multiple
+    // of 4 are cropped
+    auto decodeRows = [=](size_t beginRow, size_t endRow)
+    {
+        uint32_t texels[16];
+        for (int blockY = (int)beginRow; blockY < (int)endRow; ++blockY)
         {
-            *channels_in_file = 4;
-            output_channels = desired_channels ? desired_channels : 4;
-
-            auto* result = static_cast<unsigned char*>(malloc(*x * *y * output_channels));
-            if (!result)
-                return nullptr;
-
-            int blocksWide = (*x + 3) / 4;
-            int blocksHigh = (*y + 3) / 4;
-
-            for (int blockY = 0; blockY < blocksHigh; ++blockY)
+            int rows = (height - blockY * 4 < 4) ? height - blockY * 4 : 4;
+            for (int blockX = 0; blockX < blocksWide; ++blockX)
             {
-                for (int blockX = 0; blockX < blocksWide; ++blockX)
-                {
-                    int blockIndex = blockY * blocksWide + blockX;
-                    const uint8_t* blockData = data + blockIndex * 16;
-
-                    int outputX = blockX * 4;
-                    int outputY = blockY * 4;
-                    uint8_t* outputPtr = result + (outputY * *x + outputX) * output_channels;
+                decode_block(fourcc, blocks + (blockY * blocksWide + blockX) * blockSize, texels);
 
-                    decompress_dxt5_block(blockData, outputPtr, *x);
+                int columns = (width - blockX * 4 < 4) ? width - blockX * 4 : 4;
+                for (int row = 0; row < rows; ++row)
+                {
+                    uint8_t* output = result + ((blockY * 4 + row) * width + blockX * 4) * output_channels;
+                    const uint32_t* source = texels + row * 4;
+                    if (output_channels == 4 && columns == 4)
+                    {
+                        memcpy(output, source, 16); // Whole row, a single 16-byte store
+                        continue;
+                    }
+                    for (int column = 0; column < columns; ++column)
+                    {
+                        memcpy(output + column * output_channels, source + column, output_channels);
+                    }
                 }
             }
-
-            return result;
         }
+    };
+
+    if (blocksWide * blocksHigh >= PARALLEL_DECODE_BLOCKS)
+    {
+        ThreadPool::shared().parallelFor(blocksHigh, decodeRows);
+    }
+    else
+    {
+        decodeRows(0, blocksHigh);
     }
 
-    return nullptr; // Unsupported format
+    return 1;
 }
 
-unsigned char* stbi_load_dds(char const* filename, int* x, int* y, int* channels_in_file, int desired_channels)
+unsigned char* stbi_dds_decode_level(stbi_dds_compressed const* dds, int level, int* x, int* y,
+                                     int desired_channels)
 {
-    FILE* f = fopen(filename, "rb");
-    if (!f)
+    const unsigned char* blocks;
+    int size;
+    if (!stbi_dds_get_level(dds, level, x, y, &blocks, &size))
         return nullptr;
 
-    // Get file size
-    fseek(f, 0, SEEK_END);
-    long file_size = ftell(f);
-    fseek(f, 0, SEEK_SET);
-
-    if (file_size <= 0)
-    {
-        fclose(f);
+    int output_channels = desired_channels ? desired_channels : dds->channels;
+    auto* result = static_cast<unsigned char*>(malloc(*x * *y * output_channels));
+    if (!result)
         return nullptr;
-    }
 
-    // Read entire file
-    auto* buffer = static_cast<unsigned char*>(malloc(file_size));
-    if (!buffer)
-    {
-        fclose(f);
+    stbi_dds_decode_level_into(dds, level, result, output_channels);
+    return result;
+}
+
+unsigned char* stbi_load_dds_from_memory(unsigned char const* buffer, int len, int* x, int* y, int* channels_in_file,
+                                         int desired_channels)
+{
+    stbi_dds_compressed dds;
+    if (!stbi_dds_parse_memory(buffer, len, &dds))
         return nullptr;
-    }
 
-    size_t read = fread(buffer, 1, file_size, f);
-    fclose(f);
+    *channels_in_file = dds.channels;
+    return stbi_dds_decode_level(&dds, 0, x, y, desired_channels);
+}
 
-    if (read != static_cast<size_t>(file_size))
-    {
-        free(buffer);
+unsigned char* stbi_load_dds(char const* filename, int* x, int* y, int* channels_in_file, int desired_channels)
+{
+    // Decode straight from the mapped file, no intermediate copy of the compressed data
+    MappedFile file;
+    if (!file.open(filename) || file.size() > INT_MAX)
         return nullptr;
-    }
 
-    // Load from memory
-    unsigned char* result = stbi_load_dds_from_memory(buffer, file_size, x, y, channels_in_file, desired_channels);
-    free(buffer);
-
-    return result;
+    return stbi_load_dds_from_memory(file.data(), (int)file.size(), x, y, channels_in_file, desired_channels);
 }
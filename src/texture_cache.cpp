@@ -0,0 +1,143 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "texture_cache.hpp"
+#include <algorithm>
+
+TextureCache::Entry* TextureCache::find(const std::string& key)
+{
+    auto it = entries.find(key);
+    return it != entries.end() ? &it->second : nullptr;
+}
+
+TextureCache::Entry& TextureCache::insert(const std::string& key)
+{
+    Entry& entry = entries[key];
+    entry.lastUsed = frame;
+    return entry;
+}
+
+void TextureCache::setResident(Entry& entry, GLuint texture, size_t gpuBytes)
+{
+    // A reload replaces the previous texture in place
+    if (entry.texture)
+    {
+        glDeleteTextures(1, &entry.texture);
+        residentBytes -= entry.gpuBytes;
+    }
+
+    entry.texture = texture;
+    entry.state = State::Resident;
+    entry.gpuBytes = gpuBytes;
+    residentBytes += gpuBytes;
+}
+
+void TextureCache::setMissing(Entry& entry, uint64_t directoryGeneration)
+{
+    if (entry.texture)
+    {
+        glDeleteTextures(1, &entry.texture);
+        residentBytes -= entry.gpuBytes;
+    }
+
+    entry.texture = 0;
+    entry.state = State::Missing;
+    entry.gpuBytes = 0;
+    entry.directoryGeneration = directoryGeneration;
+}
+
+void TextureCache::recordLookup(Entry& entry, bool hit)
+{
+    bool startsRun = entry.lookupRunEnd == 0 || entry.lookupRunEnd < frame;
+    entry.lastUsed = frame;
+    entry.lookupRunEnd = frame + 1;
+    if (!startsRun)
+        return;
+    if (hit)
+        ++hits;
+    else
+        ++misses;
+}
+
+void TextureCache::setReferences(const std::vector<std::string>& keys)
+{
+    for (auto& [key, entry] : entries)
+    {
+        entry.references = 0;
+    }
+    for (const auto& key : keys)
+    {
+        auto it = entries.find(key);
+        if (it != entries.end())
+            ++it->second.references;
+    }
+}
+
+void TextureCache::endFrame()
+{
+    ++frame;
+    if (residentBytes <= budget)
+        return;
+
+    // Oldest unreferenced textures first, entries that are still loading can't be evicted
+    std::vector<std::unordered_map<std::string, Entry>::iterator> candidates;
+    for (auto it = entries.begin(); it != entries.end(); ++it)
+    {
+        if (it->second.state == State::Resident && it->second.references == 0)
+            candidates.push_back(it);
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const auto& a, const auto& b) { return a->second.lastUsed < b->second.lastUsed; });
+
+    for (auto it : candidates)
+    {
+        if (residentBytes <= budget)
+            break;
+        glDeleteTextures(1, &it->second.texture);
+        residentBytes -= it->second.gpuBytes;
+        entries.erase(it);
+    }
+}
+
+void TextureCache::clear()
+{
+    for (auto& [key, entry] : entries)
+    {
+        if (entry.texture)
+            glDeleteTextures(1, &entry.texture);
+    }
+    entries.clear();
+    residentBytes = 0;
+}
+
+TextureCache::Stats TextureCache::getStats() const
+{
+    Stats stats;
+    stats.entries = entries.size();
+    stats.bytes = residentBytes;
+    stats.budget = budget;
+    stats.hits = hits;
+    stats.misses = misses;
+    for (const auto& [key, entry] : entries)
+    {
+        if (entry.state == State::Resident)
+            ++stats.resident;
+    }
+    return stats;
+}
@@ -0,0 +1,296 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "texture_disk_cache.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+// Blob layout, little endian:
+//   0  "NTXB", version
+//   8  source size, source time, content hash
+//   32 format, compressed, width, height
+//   48 level count, source path length, data size
+//   64 levels (width, height, offset, size), source path, padding, level data
+
+namespace
+{
+    constexpr char BLOB_MAGIC[4] = {'N', 'T', 'X', 'B'};
+    constexpr uint32_t BLOB_VERSION = 1;
+    constexpr size_t HEADER_SIZE = 64;
+    constexpr size_t LEVEL_SIZE = 24;
+    constexpr size_t DATA_ALIGNMENT = 16;
+    constexpr const char* BLOB_EXTENSION = ".ntb";
+    constexpr uint64_t PRUNE_INTERVAL_DIVISOR = 8; // Prune after writing an eighth of the budget
+
+    template <typename T>
+    void put(std::vector<unsigned char>& buffer, size_t offset, T value)
+    {
+        std::memcpy(buffer.data() + offset, &value, sizeof(T));
+    }
+
+    template <typename T>
+    T get(const unsigned char* data, size_t offset)
+    {
+        T value;
+        std::memcpy(&value, data + offset, sizeof(T));
+        return value;
+    }
+
+    size_t getDataOffset(size_t levelCount, size_t pathLength)
+    {
+        size_t end = HEADER_SIZE + levelCount * LEVEL_SIZE + pathLength;
+        return (end + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+    }
+} // namespace
+
+TextureDiskCache::TextureDiskCache(std::string directory, uint64_t budget) :
+    directory(std::move(directory)), budget(budget)
+{
+}
+
+bool TextureDiskCache::load(const std::string& source, const Stamp& stamp, Blob& blob) const
+{
+    std::string blobPath = getBlobPath(source);
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(blobPath) || file->size() < HEADER_SIZE)
+        return false;
+
+    const unsigned char* data = file->data();
+    if (std::memcmp(data, BLOB_MAGIC, sizeof(BLOB_MAGIC)) != 0 || get<uint32_t>(data, 4) != BLOB_VERSION)
+        return false;
+    if (get<uint64_t>(data, 8) != stamp.size || get<int64_t>(data, 16) != stamp.time)
+        return false; // Source changed since the blob was written
+
+    uint32_t levelCount = get<uint32_t>(data, 48);
+    uint32_t pathLength = get<uint32_t>(data, 52);
+    uint64_t dataSize = get<uint64_t>(data, 56);
+    size_t dataOffset = getDataOffset(levelCount, pathLength);
+    if (levelCount == 0 || dataOffset > file->size() || dataSize > file->size() - dataOffset)
+        return false;
+
+    // Blob names are hashes of the source path, make sure this one belongs to it
+    const char* path = reinterpret_cast<const char*>(data + HEADER_SIZE + levelCount * LEVEL_SIZE);
+    if (std::string_view(path, pathLength) != source)
+        return false;
+
+    blob.levels.clear();
+    for (uint32_t i = 0; i < levelCount; ++i)
+    {
+        size_t level = HEADER_SIZE + i * LEVEL_SIZE;
+        Level l{get<int32_t>(data, level), get<int32_t>(data, level + 4),
+                static_cast<size_t>(get<uint64_t>(data, level + 8)),
+                static_cast<size_t>(get<uint64_t>(data, level + 16))};
+        if (l.offset > dataSize || l.size > dataSize - l.offset)
+            return false;
+        blob.levels.push_back(l);
+    }
+
+    blob.contentHash = get<uint64_t>(data, 24);
+    blob.format = get<uint32_t>(data, 32);
+    blob.compressed = get<uint32_t>(data, 36) != 0;
+    blob.width = get<int32_t>(data, 40);
+    blob.height = get<int32_t>(data, 44);
+    blob.data = data + dataOffset;
+    blob.dataSize = static_cast<size_t>(dataSize);
+    blob.file = std::move(file);
+
+    // The modification time doubles as the last use, prune() evicts by it
+    std::error_code ec;
+    std::filesystem::last_write_time(blobPath, std::filesystem::file_time_type::clock::now(), ec);
+    return true;
+}
+
+bool TextureDiskCache::store(const std::string& source, const Stamp& stamp, const Blob& blob) const
+{
+    size_t dataOffset = getDataOffset(blob.levels.size(), source.size());
+    std::vector<unsigned char> header(dataOffset, 0);
+    std::memcpy(header.data(), BLOB_MAGIC, sizeof(BLOB_MAGIC));
+    put<uint32_t>(header, 4, BLOB_VERSION);
+    put<uint64_t>(header, 8, stamp.size);
+    put<int64_t>(header, 16, stamp.time);
+    put<uint64_t>(header, 24, blob.contentHash);
+    put<uint32_t>(header, 32, blob.format);
+    put<uint32_t>(header, 36, blob.compressed ? 1 : 0);
+    put<int32_t>(header, 40, blob.width);
+    put<int32_t>(header, 44, blob.height);
+    put<uint32_t>(header, 48, static_cast<uint32_t>(blob.levels.size()));
+    put<uint32_t>(header, 52, static_cast<uint32_t>(source.size()));
+    put<uint64_t>(header, 56, blob.dataSize);
+    for (size_t i = 0; i < blob.levels.size(); ++i)
+    {
+        size_t level = HEADER_SIZE + i * LEVEL_SIZE;
+        put<int32_t>(header, level, blob.levels[i].width);
+        put<int32_t>(header, level + 4, blob.levels[i].height);
+        put<uint64_t>(header, level + 8, blob.levels[i].offset);
+        put<uint64_t>(header, level + 16, blob.levels[i].size);
+    }
+    std::memcpy(header.data() + HEADER_SIZE + blob.levels.size() * LEVEL_SIZE, source.data(), source.size());
+
+    // Written under a per-thread name and renamed into place, readers never see a partial blob
+    std::string path = getBlobPath(source);
+    std::string temporary = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) +
+        ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+        file.write(reinterpret_cast<const char*>(blob.data), static_cast<std::streamsize>(blob.dataSize));
+        if (!file)
+        {
+            file.close();
+            std::error_code ec;
+            std::filesystem::remove(temporary, ec);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temporary, path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(temporary, ec);
+        return false;
+    }
+
+    uint64_t written = header.size() + blob.dataSize;
+    if (bytesSincePrune.fetch_add(written) + written >= budget / PRUNE_INTERVAL_DIVISOR)
+    {
+        bytesSincePrune = 0;
+        prune();
+    }
+    return true;
+}
+
+void TextureDiskCache::prune() const
+{
+    // One scan at a time, a store that finds one running leaves the work to it
+    std::unique_lock lock(pruneMutex, std::try_to_lock);
+    if (!lock)
+        return;
+
+    struct Entry
+    {
+        std::filesystem::path path;
+        std::filesystem::file_time_type time;
+        uint64_t size;
+    };
+    std::vector<Entry> blobs;
+    uint64_t total = 0;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec))
+    {
+        if (it->path().extension() != BLOB_EXTENSION)
+            continue;
+        std::error_code entryError;
+        uint64_t size = it->file_size(entryError);
+        auto time = it->last_write_time(entryError);
+        if (entryError)
+            continue;
+        blobs.push_back({it->path(), time, size});
+        total += size;
+    }
+    if (total <= budget)
+        return;
+
+    // Down to three quarters of the budget, so the next few stores do not have to prune again
+    std::sort(blobs.begin(), blobs.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+    uint64_t target = budget / 4 * 3;
+    for (const auto& blob : blobs)
+    {
+        if (total <= target)
+            break;
+        // Blobs still mapped elsewhere stay readable on POSIX, on Windows removing them fails and they are kept
+        std::error_code removeError;
+        if (std::filesystem::remove(blob.path, removeError))
+            total -= blob.size;
+    }
+}
+
+void TextureDiskCache::clear() const
+{
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec))
+    {
+        std::string extension = it->path().extension().string();
+        if (extension == BLOB_EXTENSION || extension == ".tmp")
+        {
+            std::error_code removeError;
+            std::filesystem::remove(it->path(), removeError);
+        }
+    }
+}
+
+uint64_t TextureDiskCache::hashContent(const unsigned char* data, size_t size)
+{
+    // Eight bytes per step, fast enough that checking a blob costs little more than reading its source
+    uint64_t hash = 0x9E3779B97F4A7C15ull ^ size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        hash = (hash ^ get<uint64_t>(data, i)) * 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 32;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, data + i, size - i);
+    hash = (hash ^ tail) * 0xFF51AFD7ED558CCDull;
+
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+std::string TextureDiskCache::getDefaultDirectory()
+{
+    std::filesystem::path base;
+#ifdef _WIN32
+    const char* localAppData = std::getenv("LOCALAPPDATA");
+    base = localAppData ? localAppData : ".";
+#else
+    const char* cacheHome = std::getenv("XDG_CACHE_HOME");
+    const char* home = std::getenv("HOME");
+    if (cacheHome && cacheHome[0] != '\0')
+        base = cacheHome;
+    else
+        base = std::filesystem::path(home ? home : ".") / ".cache";
+#endif
+    return (base / "nwn_emitter_editor" / "textures").string();
+}
+
+std::string TextureDiskCache::getBlobPath(const std::string& source) const
+{
+    // FNV-1a of the source path
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : source)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+
+    char name[24];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+    return (std::filesystem::path(directory) / (std::string(name) + BLOB_EXTENSION)).string();
+}
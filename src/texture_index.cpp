@@ -0,0 +1,144 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "texture_index.hpp"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    std::string toLower(std::string_view text)
+    {
+        std::string lower(text);
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+        return lower;
+    }
+
+    std::string normalizeDirectory(const std::string& directory)
+    {
+        return (fs::path(directory) / "").lexically_normal().string();
+    }
+} // namespace
+
+void TextureIndex::scan(const std::string& path)
+{
+    clear();
+    directory = path;
+
+    std::error_code ec;
+    for (fs::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec))
+    {
+        if (getFormat(it->path().filename().string()) != TextureFormat::None && it->is_regular_file(ec))
+            addFile(it->path().string());
+    }
+}
+
+void TextureIndex::fileChanged(const std::string& path)
+{
+    fs::path file(path);
+    if (directory.empty() || normalizeDirectory(file.parent_path().string()) != normalizeDirectory(directory))
+        return;
+    if (getFormat(file.filename().string()) == TextureFormat::None)
+        return;
+
+    std::string key = toLower(file.stem().string());
+    auto it = textures.find(key);
+    if (it != textures.end())
+    {
+        // Forget the file, it is added back below if it still exists
+        auto& paths = it->second.paths;
+        std::string filename = file.filename().string();
+        std::erase_if(paths, [&](const std::string& p) { return fs::path(p).filename() == filename; });
+        if (paths.empty())
+            textures.erase(it);
+        else
+            it->second.name = fs::path(paths.front()).stem().string();
+        sortedValid = false;
+    }
+
+    std::error_code ec;
+    if (fs::is_regular_file(file, ec))
+        addFile(path);
+}
+
+void TextureIndex::clear()
+{
+    directory.clear();
+    textures.clear();
+    sorted.clear();
+    sortedValid = false;
+}
+
+const TextureIndex::Texture* TextureIndex::find(std::string_view name) const
+{
+    auto it = textures.find(toLower(name));
+    return it != textures.end() ? &it->second : nullptr;
+}
+
+const std::vector<const TextureIndex::Texture*>& TextureIndex::getTextures() const
+{
+    if (!sortedValid)
+    {
+        sorted.clear();
+        for (const auto& [key, texture] : textures)
+        {
+            sorted.push_back(&texture);
+        }
+        std::sort(sorted.begin(), sorted.end(),
+                  [](const Texture* a, const Texture* b) { return toLower(a->name) < toLower(b->name); });
+        sortedValid = true;
+    }
+    return sorted;
+}
+
+TextureFormat TextureIndex::getFormat(std::string_view filename)
+{
+    size_t dot = filename.rfind('.');
+    if (dot == std::string_view::npos)
+        return TextureFormat::None;
+
+    std::string ext = toLower(filename.substr(dot));
+    if (ext == ".dds")
+        return TextureFormat::DDS;
+    if (ext == ".tga")
+        return TextureFormat::TGA;
+    if (ext == ".png")
+        return TextureFormat::PNG;
+    if (ext == ".jpg")
+        return TextureFormat::JPG;
+    return TextureFormat::None;
+}
+
+void TextureIndex::addFile(const std::string& path)
+{
+    fs::path file(path);
+    Texture& texture = textures[toLower(file.stem().string())];
+
+    auto priority = [](const std::string& p) { return getFormat(fs::path(p).filename().string()); };
+    auto position = std::upper_bound(texture.paths.begin(), texture.paths.end(), path,
+                                     [&](const std::string& a, const std::string& b)
+                                     { return priority(a) < priority(b); });
+    texture.paths.insert(position, path);
+    texture.name = fs::path(texture.paths.front()).stem().string();
+    sortedValid = false;
+}
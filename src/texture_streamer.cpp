@@ -0,0 +1,674 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "texture_streamer.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string_view>
+#include <system_error>
+#include "stb_dds.hpp"
+#include "thread_pool.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+// S3TC formats, not part of core GL and not in the generated loader
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace
+{
+    GLenum channelFormat(int channels)
+    {
+        if (channels == 4)
+            return GL_RGBA;
+        if (channels == 1)
+            return GL_RED;
+        return GL_RGB;
+    }
+
+    bool equalsIgnoreCase(std::string_view a, std::string_view b)
+    {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                          [](unsigned char x, unsigned char y) { return std::tolower(x) == std::tolower(y); });
+    }
+
+    using FileBuffer = std::unique_ptr<unsigned char, decltype(&std::free)>;
+
+    // Loose files are copied rather than mapped: other tools rewrite them in place, and touching the pages of a
+    // mapping whose file was truncated underneath it kills the process. A read only comes up short.
+    bool readLooseFile(const std::string& path, FileBuffer& buffer, size_t& size)
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file)
+            return false;
+        auto length = static_cast<std::streamoff>(file.tellg());
+        if (length <= 0)
+            return false;
+        buffer.reset(static_cast<unsigned char*>(std::malloc(static_cast<size_t>(length))));
+        if (!buffer)
+            return false;
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(buffer.get()), length);
+        size = static_cast<size_t>(file.gcount());
+        return size > 0;
+    }
+} // namespace
+
+void TextureStreamer::initialize()
+{
+    // DXT textures can skip the CPU decoder when the driver takes S3TC blocks directly
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (GLint i = 0; i < extensionCount; ++i)
+    {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension && std::strcmp(extension, "GL_EXT_texture_compression_s3tc") == 0)
+        {
+            compressedTexturesSupported = true;
+            break;
+        }
+    }
+
+    // Mid-grey stand-in, keeps emitters visible without flashing white while their texture streams in
+    const unsigned char grey[4] = {128, 128, 128, 255};
+    glGenTextures(1, &placeholderTexture);
+    glBindTexture(GL_TEXTURE_2D, placeholderTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenBuffers(1, &uploadBuffer);
+}
+
+void TextureStreamer::cleanup()
+{
+    cache.clear();
+    watcher.clear();
+    ++generation;
+
+    {
+        std::lock_guard lock(readyQueue->mutex);
+        readyQueue->decoded.clear();
+    }
+
+    if (placeholderTexture)
+    {
+        glDeleteTextures(1, &placeholderTexture);
+        placeholderTexture = 0;
+    }
+    if (uploadBuffer)
+    {
+        glDeleteBuffers(1, &uploadBuffer);
+        uploadBuffer = 0;
+    }
+}
+
+void TextureStreamer::setTextureDirectory(const std::string& directory)
+{
+    if (directory == textureDirectory)
+        return;
+    textureDirectory = directory;
+    ++directoryGeneration;
+    textureIndex.scan(directory);
+    watcher.watchDirectory(directory);
+}
+
+void TextureStreamer::setDiskCacheDirectory(const std::string& directory)
+{
+    if (directory.empty())
+    {
+        diskCache.reset();
+        return;
+    }
+    if (diskCache && diskCache->getDirectory() == directory)
+        return;
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec)
+    {
+        std::cerr << "Texture disk cache disabled, cannot create " << directory << ": " << ec.message() << std::endl;
+        diskCache.reset();
+        return;
+    }
+    diskCache = std::make_shared<const TextureDiskCache>(directory);
+
+    // Blobs left by earlier sessions count against the budget too
+    ThreadPool::shared().submit([cache = diskCache] { cache->prune(); });
+}
+
+void TextureStreamer::request(const std::string& textureNameOrPath)
+{
+    if (textureNameOrPath.empty())
+        return;
+
+    TextureCache::Entry* entry = cache.find(textureNameOrPath);
+    if (entry)
+    {
+        // Names that were not found before get another try once they could resolve to a different file
+        if (entry->state != TextureCache::State::Missing || entry->directoryGeneration == directoryGeneration)
+            return;
+        entry->state = TextureCache::State::Loading;
+    }
+    else
+    {
+        cache.insert(textureNameOrPath);
+    }
+    submit(textureNameOrPath, compressedTexturesSupported);
+}
+
+GLuint TextureStreamer::get(const std::string& textureNameOrPath)
+{
+    if (textureNameOrPath.empty())
+        return 0;
+
+    request(textureNameOrPath);
+
+    TextureCache::Entry* entry = cache.find(textureNameOrPath);
+    bool resident = entry->state == TextureCache::State::Resident;
+    cache.recordLookup(*entry, resident);
+    if (entry->state == TextureCache::State::Loading)
+        return placeholderTexture;
+    return entry->texture;
+}
+
+void TextureStreamer::setReferencedTextures(const std::vector<std::string>& textureNames)
+{
+    cache.setReferences(textureNames);
+}
+
+std::vector<TextureStreamer::Source> TextureStreamer::resolve(const std::string& key) const
+{
+    // A full path is loaded directly, a bare name is looked up in the texture directory's index
+    std::vector<Source> sources;
+    if (key.find('/') != std::string::npos || key.find('\\') != std::string::npos)
+    {
+        sources.push_back({key, {}, TextureIndex::getFormat(key)});
+        return sources;
+    }
+
+    if (const TextureIndex::Texture* texture = textureIndex.find(key))
+    {
+        for (const auto& path : texture->paths)
+        {
+            sources.push_back({path, {}, TextureIndex::getFormat(path)});
+        }
+    }
+
+    // Loose files next to the model override textures from archives
+    if (resources)
+    {
+        if (auto resource = resources->find(key, ResourceType::DDS))
+            sources.push_back({resource.location, resource, TextureFormat::DDS});
+        if (auto resource = resources->find(key, ResourceType::TGA))
+            sources.push_back({resource.location, resource, TextureFormat::TGA});
+    }
+    return sources;
+}
+
+void TextureStreamer::submit(const std::string& key, bool allowCompressed)
+{
+    // Decodes of one key can finish out of order, the sequence lets update() keep the newest. It is counted across
+    // all keys so an entry that was evicted and inserted again still outranks decodes for its earlier self.
+    uint64_t sequence = ++requestSequence;
+
+    ThreadPool::shared().submit(
+        [queue = readyQueue, key, sources = resolve(key), currentGeneration = generation, sequence, allowCompressed,
+         diskCache = diskCache]
+        {
+            Decoded result;
+            result.key = key;
+            result.generation = currentGeneration;
+            result.sequence = sequence;
+            decode(result, sources, allowCompressed, diskCache.get());
+
+            bool fromDiskCache = result.fromDiskCache;
+            std::string path = result.path;
+            uint64_t contentHash = result.contentHash;
+            {
+                std::lock_guard lock(queue->mutex);
+                queue->decoded.push_back(std::move(result));
+            }
+            if (!fromDiskCache)
+                return;
+
+            // The blob is already on its way to the GPU. Its source is hashed in a job of its own, behind the
+            // blobs of other textures, and decoded again if the size and time missed a change. The fresh decode
+            // answers the same request, so it keeps the sequence and replaces the blob unless something newer won.
+            auto source = std::find_if(sources.begin(), sources.end(),
+                                       [&](const Source& candidate) { return candidate.path == path; });
+            ThreadPool::shared().submit(
+                [queue, key, source = *source, currentGeneration, sequence, allowCompressed, diskCache, contentHash]
+                {
+                    uint64_t hash;
+                    if (!hashSource(source, hash) || hash == contentHash)
+                        return;
+
+                    Decoded fresh;
+                    fresh.key = key;
+                    fresh.generation = currentGeneration;
+                    fresh.sequence = sequence;
+                    decode(fresh, {source}, allowCompressed, diskCache.get(), false);
+
+                    std::lock_guard lock(queue->mutex);
+                    queue->decoded.push_back(std::move(fresh));
+                });
+        });
+}
+
+bool TextureStreamer::hashSource(const Source& source, uint64_t& hash)
+{
+    if (source.resource)
+    {
+        hash = TextureDiskCache::hashContent(source.resource.data, source.resource.size);
+        return true;
+    }
+    FileBuffer buffer{nullptr, &std::free};
+    size_t size = 0;
+    if (!readLooseFile(source.path, buffer, size))
+        return false;
+    hash = TextureDiskCache::hashContent(buffer.get(), size);
+    return true;
+}
+
+bool TextureStreamer::getStamp(const Source& source, TextureDiskCache::Stamp& stamp)
+{
+    // Resources have no time of their own, the archive's is used so rebuilding it invalidates their blobs
+    if (source.resource)
+    {
+        stamp = {source.resource.size, source.resource.time};
+        return true;
+    }
+
+    std::error_code ec;
+    auto size = std::filesystem::file_size(source.path, ec);
+    if (ec)
+        return false;
+    auto time = std::filesystem::last_write_time(source.path, ec);
+    if (ec)
+        return false;
+    stamp = {static_cast<uint64_t>(size), static_cast<int64_t>(time.time_since_epoch().count())};
+    return true;
+}
+
+void TextureStreamer::store(const TextureDiskCache& diskCache, const Source& source,
+                            const TextureDiskCache::Stamp& stamp, uint64_t contentHash, const Decoded& decoded)
+{
+    TextureDiskCache::Blob blob;
+    blob.format = decoded.format;
+    blob.compressed = decoded.compressed;
+    blob.width = decoded.width;
+    blob.height = decoded.height;
+    blob.contentHash = contentHash;
+    for (const auto& level : decoded.levels)
+    {
+        blob.levels.push_back({level.width, level.height, level.offset, level.size});
+    }
+    blob.data = decoded.data;
+    blob.dataSize = decoded.dataSize;
+    if (!diskCache.store(source.path, stamp, blob))
+        std::cerr << "Failed to write texture cache blob: " << source.path << std::endl;
+}
+
+void TextureStreamer::decode(Decoded& result, const std::vector<Source>& sources, bool allowCompressed,
+                             const TextureDiskCache* diskCache, bool readDiskCache)
+{
+    // Sources are in priority order, a file that fails to decode falls through to the next one
+    for (const auto& source : sources)
+    {
+        // DXT blocks the driver takes directly are uploaded from the source itself, a blob would only copy them
+        bool useDiskCache = diskCache && !(allowCompressed && source.format == TextureFormat::DDS);
+        TextureDiskCache::Stamp stamp;
+        if (useDiskCache && !getStamp(source, stamp))
+            continue;
+
+        TextureDiskCache::Blob blob;
+        if (useDiskCache && readDiskCache && diskCache->load(source.path, stamp, blob))
+        {
+            result.path = source.path;
+            result.archived = static_cast<bool>(source.resource);
+            result.compressed = blob.compressed;
+            result.format = blob.format;
+            result.width = blob.width;
+            result.height = blob.height;
+            for (const auto& level : blob.levels)
+            {
+                result.levels.push_back({level.width, level.height, level.offset, level.size});
+            }
+            result.data = blob.data;
+            result.dataSize = blob.dataSize;
+            result.file = std::move(blob.file);
+            result.fromDiskCache = true;
+            result.contentHash = blob.contentHash;
+            result.loaded = true;
+            return;
+        }
+
+        // Archives are mapped and only ever replaced whole, loose files are read into memory
+        std::shared_ptr<const MappedFile> file = source.resource.file;
+        const unsigned char* data = source.resource.data;
+        size_t size = source.resource.size;
+        FileBuffer loose{nullptr, &std::free};
+        if (!source.resource)
+        {
+            if (!readLooseFile(source.path, loose, size))
+                continue;
+            data = loose.get();
+        }
+        if (size > static_cast<size_t>(std::numeric_limits<int>::max()))
+            continue;
+        result.path = source.path;
+        result.archived = static_cast<bool>(source.resource);
+
+        if (source.format != TextureFormat::DDS)
+        {
+            // The flip setting is per thread, workers have to set it themselves
+            stbi_set_flip_vertically_on_load_thread(1);
+            int channels;
+            unsigned char* pixels =
+                stbi_load_from_memory(data, static_cast<int>(size), &result.width, &result.height, &channels, 0);
+            if (!pixels)
+                continue;
+
+            result.format = channelFormat(channels);
+            result.pixels.reset(pixels);
+            result.data = pixels;
+            result.dataSize = static_cast<size_t>(result.width) * result.height * channels;
+            result.levels.push_back({result.width, result.height, 0, result.dataSize});
+            result.loaded = true;
+            if (useDiskCache)
+                store(*diskCache, source, stamp, TextureDiskCache::hashContent(data, size), result);
+            return;
+        }
+
+        stbi_dds_compressed dds;
+        if (!stbi_dds_parse_memory(data, static_cast<int>(size), &dds))
+            continue;
+
+        result.width = dds.width;
+        result.height = dds.height;
+
+        if (allowCompressed)
+        {
+            result.compressed = true;
+            result.format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            if (dds.fourcc == 1)
+                result.format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            else if (dds.fourcc == 3)
+                result.format = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+
+            for (int level = 0; level < dds.levels; ++level)
+            {
+                int width, height, size;
+                const unsigned char* blocks;
+                stbi_dds_get_level(&dds, level, &width, &height, &blocks, &size);
+                result.levels.push_back({width, height, static_cast<size_t>(blocks - dds.blocks),
+                                         static_cast<size_t>(size)});
+                result.dataSize += size;
+            }
+            // Keep the blocks alive until they are uploaded
+            result.data = dds.blocks;
+            result.file = std::move(file);
+            result.pixels = std::move(loose);
+            result.loaded = true;
+            return;
+        }
+
+        // Decode every stored level back to back into one buffer
+        result.format = channelFormat(dds.channels);
+        for (int level = 0; level < dds.levels; ++level)
+        {
+            int width, height, size;
+            const unsigned char* blocks;
+            stbi_dds_get_level(&dds, level, &width, &height, &blocks, &size);
+            size_t bytes = static_cast<size_t>(width) * height * dds.channels;
+            result.levels.push_back({width, height, result.dataSize, bytes});
+            result.dataSize += bytes;
+        }
+
+        result.pixels.reset(static_cast<unsigned char*>(std::malloc(result.dataSize)));
+        if (!result.pixels)
+            return;
+        for (int level = 0; level < dds.levels; ++level)
+        {
+            stbi_dds_decode_level_into(&dds, level, result.pixels.get() + result.levels[level].offset,
+                                       dds.channels);
+        }
+        result.data = result.pixels.get();
+        result.loaded = true;
+        if (useDiskCache)
+            store(*diskCache, source, stamp, TextureDiskCache::hashContent(data, size), result);
+        return;
+    }
+}
+
+void TextureStreamer::reloadChangedFiles()
+{
+    namespace fs = std::filesystem;
+
+    fs::path directory = (fs::path(textureDirectory) / "").lexically_normal();
+    for (const auto& changed : watcher.poll())
+    {
+        textureIndex.fileChanged(changed);
+
+        fs::path changedPath = fs::path(changed).lexically_normal();
+        bool inTextureDirectory = changedPath.parent_path() / "" == directory;
+        std::string stem = changedPath.stem().string();
+
+        std::vector<std::string> keys;
+        cache.forEach(
+            [&](const std::string& key, TextureCache::Entry& entry)
+            {
+                // A new, edited or removed file can change what a bare name with the same stem resolves to
+                bool bareName = key.find('/') == std::string::npos && key.find('\\') == std::string::npos;
+                bool affected = fs::path(entry.path).lexically_normal() == changedPath ||
+                    (!bareName && fs::path(key).lexically_normal() == changedPath) ||
+                    (bareName && inTextureDirectory && equalsIgnoreCase(key, stem));
+                if (!affected || entry.state == TextureCache::State::Loading)
+                    return;
+
+                if (entry.state == TextureCache::State::Missing)
+                    entry.state = TextureCache::State::Loading;
+                keys.push_back(key);
+            });
+
+        // Resident textures stay bound until their replacement is uploaded
+        for (const auto& key : keys)
+        {
+            submit(key, compressedTexturesSupported);
+        }
+    }
+}
+
+void TextureStreamer::reloadArchiveTextures()
+{
+    if (!resources || resources->getRevision() == resourceRevision)
+        return;
+    resourceRevision = resources->getRevision();
+
+    // Names that were not found get another try on their next request
+    ++directoryGeneration;
+
+    // Resident textures whose name now resolves to a different file, stale ones stay bound until replaced
+    std::vector<std::string> keys;
+    cache.forEach(
+        [&](const std::string& key, TextureCache::Entry& entry)
+        {
+            if (entry.state != TextureCache::State::Resident)
+                return;
+            std::vector<Source> sources = resolve(key);
+            if (!sources.empty() && sources.front().path != entry.path)
+                keys.push_back(key);
+        });
+    for (const auto& key : keys)
+    {
+        submit(key, compressedTexturesSupported);
+    }
+}
+
+void TextureStreamer::update()
+{
+    reloadChangedFiles();
+    reloadArchiveTextures();
+
+    size_t budget = uploadBudget;
+    bool first = true;
+
+    for (;;)
+    {
+        Decoded decoded;
+        {
+            std::lock_guard lock(readyQueue->mutex);
+            if (readyQueue->decoded.empty())
+                break;
+            // Always make progress, even on a texture larger than the whole budget
+            if (!first && readyQueue->decoded.front().dataSize > budget)
+                break;
+            decoded = std::move(readyQueue->decoded.front());
+            readyQueue->decoded.pop_front();
+        }
+        first = false;
+
+        // Results of requests older than the resident texture would bring back earlier file contents
+        TextureCache::Entry* entry = cache.find(decoded.key);
+        if (decoded.generation != generation || !entry || decoded.sequence < entry->residentSequence)
+            continue;
+
+        GLuint texture = decoded.loaded ? upload(decoded) : 0;
+        budget -= std::min(budget, decoded.dataSize);
+        if (!texture && decoded.loaded && decoded.compressed)
+        {
+            // The driver rejected the blocks, decode this file on the CPU instead
+            submit(decoded.key, false);
+            continue;
+        }
+
+        if (!texture && entry->state == TextureCache::State::Resident)
+        {
+            // A file caught while being replaced, or removed; the previous version is better than nothing
+            std::cerr << "Failed to reload texture: " << decoded.key << std::endl;
+            continue;
+        }
+
+        if (!texture)
+        {
+            cache.setMissing(*entry, directoryGeneration);
+            std::cerr << "Failed to load texture: " << decoded.key << std::endl;
+            continue;
+        }
+
+        // Mipmaps generated on the GPU add about a third on top of the uploaded level
+        size_t gpuBytes = decoded.dataSize;
+        if (decoded.levels.size() == 1 && !decoded.compressed)
+            gpuBytes += gpuBytes / 3;
+        cache.setResident(*entry, texture, gpuBytes);
+        entry->path = decoded.path;
+        entry->residentSequence = decoded.sequence;
+        if (!decoded.archived)
+            watcher.watchFile(decoded.path);
+
+        std::cout << "Loaded texture: " << decoded.path << " (" << decoded.width << "x" << decoded.height << ")"
+                  << (decoded.fromDiskCache ? " from disk cache" : "") << std::endl;
+    }
+}
+
+GLuint TextureStreamer::upload(const Decoded& decoded)
+{
+    // Clear stale errors so the check below only sees this upload
+    while (glGetError() != GL_NO_ERROR)
+    {
+    }
+
+    // Copy into a freshly orphaned buffer so the driver never waits for the previous upload to finish
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploadBuffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(decoded.dataSize), nullptr, GL_STREAM_DRAW);
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(decoded.dataSize),
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!mapped)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return 0;
+    }
+    std::memcpy(mapped, decoded.data, decoded.dataSize);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    // Rows of small RGB levels are not 4-byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t level = 0; level < decoded.levels.size(); ++level)
+    {
+        const Level& l = decoded.levels[level];
+        const void* offset = reinterpret_cast<const void*>(l.offset);
+        if (decoded.compressed)
+        {
+            glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), decoded.format, l.width, l.height, 0,
+                                   static_cast<GLsizei>(l.size), offset);
+        }
+        else
+        {
+            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), static_cast<GLint>(decoded.format), l.width,
+                         l.height, 0, decoded.format, GL_UNSIGNED_BYTE, offset);
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (decoded.levels.size() > 1)
+    {
+        // Use the authored mips, a partial chain stops at the last stored level
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(decoded.levels.size()) - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    }
+    else if (!decoded.compressed)
+    {
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    }
+    else
+    {
+        // Mipmaps can't be generated from compressed data
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (glGetError() != GL_NO_ERROR)
+    {
+        glDeleteTextures(1, &texture);
+        return 0;
+    }
+    return texture;
+}
@@ -0,0 +1,134 @@
+/*
+ * This file is part of NWN Emitter Editor.
+ * Copyright (C) 2025 Varenx
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned threadCount)
+{
+    if (threadCount == 0)
+    {
+        unsigned hardwareThreads = std::thread::hardware_concurrency();
+        threadCount = hardwareThreads > 2 ? hardwareThreads - 1 : 1;
+    }
+
+    workers.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i)
+    {
+        workers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    condition.notify_one();
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& body)
+{
+    if (count == 0)
+        return;
+
+    size_t chunkCount = std::min(count, workers.size() + 1);
+    if (chunkCount == 1)
+    {
+        body(0, count);
+        return;
+    }
+
+    // Helpers can start after this call returned, so everything they touch is shared
+    struct Job
+    {
+        std::function<void(size_t, size_t)> body;
+        size_t count;
+        size_t chunkCount;
+        std::atomic<size_t> nextChunk{0};
+        size_t finishedChunks = 0;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto job = std::make_shared<Job>();
+    job->body = body;
+    job->count = count;
+    job->chunkCount = chunkCount;
+
+    auto runChunks = [](Job& job)
+    {
+        size_t chunk;
+        while ((chunk = job.nextChunk.fetch_add(1)) < job.chunkCount)
+        {
+            job.body(chunk * job.count / job.chunkCount, (chunk + 1) * job.count / job.chunkCount);
+
+            std::lock_guard lock(job.mutex);
+            if (++job.finishedChunks == job.chunkCount)
+                job.finished.notify_all();
+        }
+    };
+
+    for (size_t i = 1; i < chunkCount; ++i)
+    {
+        submit([job, runChunks] { runChunks(*job); });
+    }
+    runChunks(*job);
+
+    std::unique_lock lock(job->mutex);
+    job->finished.wait(lock, [&] { return job->finishedChunks == job->chunkCount; });
+}
+
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::workerLoop()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(mutex);
+            condition.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty())
+                return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}